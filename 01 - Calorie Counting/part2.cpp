@@ -1,23 +1,40 @@
 #include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <compare>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
 #include <iostream>
-#include <numeric>
-#include <regex>
+#include <optional>
+#include <random>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using Calories = std::uint64_t;
+
+// Number of elves whose calories are added up when none is given.
+constexpr std::size_t defaultTopCount = 3;
+
 class Elf
 {
 public:
     Elf() = default;
     ~Elf() = default;
 
-    int get_calories() const {
-        return std::accumulate(_snacks.begin(), _snacks.end(), 0);
+    Calories get_calories() const {
+        return _calories;
     }
 
-    void add_snack(const int snack) {
-        _snacks.push_back(snack);
+    void add_snack(const Calories snack) {
+        _calories += snack;
     }
 
     static bool cmp(const Elf & a, const Elf & b) {
@@ -25,42 +42,367 @@ public:
         return cmp < 0;
     }
 private:
-    std::vector<int> _snacks;
+    Calories _calories = 0;
 };
 
-std::vector<Elf> parse_elves()
+// The k elves carrying the most calories, kept in a min-heap so the
+// smallest of them is the one to replace.
+class TopElves
 {
-    std::vector<Elf> elves;
+public:
+    explicit TopElves(std::size_t k)
+        : _k(k)
+    {
+        _heap.reserve(k);
+    }
+
+    ~TopElves() = default;
+
+    void add(const Elf & elf) {
+        if (_k == 0) {
+            return;
+        }
 
-    Elf curr;
-    
-    for (std::string line; std::getline(std::cin, line);) {
-        if ((line.empty()) || (std::regex_match(line, std::regex("^\\s+$")))) {
-            elves.push_back(curr);
-            curr = Elf();
-            continue;
+        if (_heap.size() < _k) {
+            _heap.push_back(elf);
+            std::push_heap(_heap.begin(), _heap.end(), std::not_fn(Elf::cmp));
+            return;
         }
 
-        curr.add_snack(std::stoi(line));
+        if (Elf::cmp(_heap.front(), elf)) {
+            std::pop_heap(_heap.begin(), _heap.end(), std::not_fn(Elf::cmp));
+            _heap.back() = elf;
+            std::push_heap(_heap.begin(), _heap.end(), std::not_fn(Elf::cmp));
+        }
+    }
+
+    void merge(const TopElves & other) {
+        for (const auto & elf : other._heap) {
+            add(elf);
+        }
     }
 
-    elves.push_back(curr);
+    Calories get_calories() const {
+        Calories total = 0;
+
+        for (const auto & elf : _heap) {
+            total += elf.get_calories();
+        }
+
+        return total;
+    }
+private:
+    std::size_t _k;
+    std::vector<Elf> _heap;
+};
+
+// What one chunk of an inventory contributes: the elves wholly inside it,
+// plus the partial elves cut by its edges. An unseparated chunk is a single
+// fragment, held in head.
+struct ChunkSummary
+{
+    Elf head;
+    bool separated;
+    TopElves inner;
+    Elf tail;
+};
+
+// Folds an inventory into TopElves as it arrives, one buffer at a time.
+// Lines holding only whitespace separate elves. The first elf is held back
+// until the end so a chunk's leading fragment can be joined to the previous
+// chunk.
+class ElfParser
+{
+public:
+    explicit ElfParser(std::size_t k)
+        : _top(k)
+    {}
+
+    ~ElfParser() = default;
+
+    void feed(std::string_view bytes) {
+        for (char c : bytes) {
+            if ((c >= '0') && (c <= '9')) {
+                _snack = _snack * 10 + (c - '0');
+                _lineHasSnack = true;
+            }
+            else if (c == '\n') {
+                end_line();
+            }
+            else if ((c != ' ') && (c != '\t') && (c != '\r') && (c != '\v') && (c != '\f')) {
+                std::cerr << "unexpected character in inventory: '" << c << "'" << std::endl;
+                std::terminate();
+            }
+        }
+    }
+
+    TopElves finish() {
+        auto chunk = finish_chunk();
+
+        // An unseparated inventory is a single elf held in head; its tail is
+        // empty and adding it is harmless.
+        chunk.inner.add(chunk.head);
+        chunk.inner.add(chunk.tail);
+        return chunk.inner;
+    }
 
-    return elves;
+    ChunkSummary finish_chunk() {
+        if (_lineHasSnack) {
+            end_line();
+        }
+
+        if (!_separated) {
+            return {_current, false, _top, Elf()};
+        }
+
+        return {_head, true, _top, _current};
+    }
+private:
+    void end_line() {
+        if (_lineHasSnack) {
+            _current.add_snack(_snack);
+        }
+        else {
+            if (_separated) {
+                _top.add(_current);
+            }
+            else {
+                _head = _current;
+                _separated = true;
+            }
+
+            _current = Elf();
+        }
+
+        _snack = 0;
+        _lineHasSnack = false;
+    }
+
+    TopElves _top;
+    Elf _head;
+    bool _separated = false;
+    Elf _current;
+    Calories _snack = 0;
+    bool _lineHasSnack = false;
+};
+
+TopElves parse_elves(std::istream & is, std::size_t k)
+{
+    ElfParser parser(k);
+    std::vector<char> buffer(1 << 16);
+
+    while (is.read(buffer.data(), buffer.size()) || (is.gcount() > 0)) {
+        parser.feed({buffer.data(), static_cast<std::size_t>(is.gcount())});
+    }
+
+    return parser.finish();
 }
 
-int main()
+// Whole input, memory-mapped when it is a regular file and read into
+// memory otherwise.
+class InputBuffer
 {
-    auto elves = parse_elves();
+public:
+    explicit InputBuffer(int fd) {
+        struct stat info;
+
+        if ((fstat(fd, &info) == 0) && S_ISREG(info.st_mode) && (info.st_size > 0)) {
+            void * mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapping != MAP_FAILED) {
+                _mapping = mapping;
+                _bytes = {static_cast<const char *>(mapping), static_cast<std::size_t>(info.st_size)};
+                return;
+            }
+        }
+
+        std::vector<char> buffer(1 << 16);
 
-    std::sort(elves.begin(), elves.end(), Elf::cmp);
+        for (ssize_t count; (count = read(fd, buffer.data(), buffer.size())) > 0;) {
+            _contents.append(buffer.data(), count);
+        }
+
+        _bytes = _contents;
+    }
+
+    explicit InputBuffer(std::string contents)
+        : _contents(std::move(contents)),
+          _bytes(_contents)
+    {}
+
+    InputBuffer(const InputBuffer &) = delete;
+    InputBuffer & operator=(const InputBuffer &) = delete;
+
+    ~InputBuffer() {
+        if (_mapping != nullptr) {
+            munmap(_mapping, _bytes.size());
+        }
+    }
+
+    std::string_view bytes() const { return _bytes; }
+private:
+    void * _mapping = nullptr;
+    std::string _contents;
+    std::string_view _bytes;
+};
+
+// Runs work(chunk, begin, end) over count items split evenly between
+// threadCount threads, the first chunk on the calling thread.
+template <typename Work>
+void parallelFor(std::size_t count, unsigned threadCount, Work work)
+{
+    auto chunkBegin = [&](unsigned chunk) {
+        return count * chunk / threadCount;
+    };
+
+    std::vector<std::thread> workers;
+
+    for (unsigned chunk = 1; chunk < threadCount; ++chunk) {
+        workers.emplace_back(work, chunk, chunkBegin(chunk), chunkBegin(chunk + 1));
+    }
+
+    work(0u, chunkBegin(0), chunkBegin(1));
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+}
+
+// Splits the inventory into one chunk per thread, each starting at a line
+// boundary, and joins the elves cut by the chunk edges afterwards.
+TopElves parse_elves_parallel(std::string_view bytes, std::size_t k, unsigned threadCount)
+{
+    std::vector<std::size_t> boundaries(threadCount + 1, bytes.size());
+    boundaries[0] = 0;
+
+    for (unsigned chunk = 1; chunk < threadCount; ++chunk) {
+        auto start = std::max(boundaries[chunk - 1], bytes.size() * chunk / threadCount);
+        auto newline = bytes.find('\n', start);
+        boundaries[chunk] = (newline == std::string_view::npos) ? bytes.size() : newline + 1;
+    }
+
+    std::vector<std::optional<ChunkSummary>> summaries(threadCount);
+
+    parallelFor(threadCount, threadCount, [&](unsigned, std::size_t begin, std::size_t end) {
+        for (auto chunk = begin; chunk < end; ++chunk) {
+            ElfParser parser(k);
+            parser.feed(bytes.substr(boundaries[chunk], boundaries[chunk + 1] - boundaries[chunk]));
+            summaries[chunk] = parser.finish_chunk();
+        }
+    });
+
+    TopElves top(k);
+    Elf carried;
+
+    for (const auto & summary : summaries) {
+        carried.add_snack(summary->head.get_calories());
+
+        if (summary->separated) {
+            top.add(carried);
+            top.merge(summary->inner);
+            carried = summary->tail;
+        }
+    }
+
+    top.add(carried);
+    return top;
+}
+
+// Writes an inventory of elfCount elves with one to fifteen snacks each.
+std::string generate_inventory(std::size_t elfCount)
+{
+    std::mt19937 rng{1};
+    std::uniform_int_distribution<int> snackCountDist{1, 15};
+    std::uniform_int_distribution<int> snackDist{1000, 70000};
+    std::ostringstream oss;
+
+    for (std::size_t elf = 0; elf < elfCount; ++elf) {
+        if (elf > 0) {
+            oss << "\n";
+        }
+
+        for (int snacks = snackCountDist(rng); snacks > 0; --snacks) {
+            oss << snackDist(rng) << "\n";
+        }
+    }
+
+    return oss.str();
+}
+
+// Times a generated inventory streamed sequentially, then split between
+// 1, 2, 4... threads.
+void benchmark(std::size_t elfCount, std::size_t k, unsigned maxThreads)
+{
+    InputBuffer inventory{generate_inventory(elfCount)};
+    auto bytes{inventory.bytes()};
+
+    auto report = [&](const std::string & name, auto start, const TopElves & top) {
+        std::chrono::duration<double> seconds{std::chrono::steady_clock::now() - start};
+        std::cout << std::setw(12) << std::left << name
+                  << std::setw(16) << top.get_calories()
+                  << std::fixed << std::setprecision(3)
+                  << bytes.size() / seconds.count() / 1e9 << " GB/s" << std::endl;
+    };
+
+    std::cout << elfCount << " elves, " << bytes.size() << " bytes" << std::endl;
+
+    auto start{std::chrono::steady_clock::now()};
+    ElfParser parser(k);
+    parser.feed(bytes);
+    report("sequential", start, parser.finish());
+
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        start = std::chrono::steady_clock::now();
+        auto top{parse_elves_parallel(bytes, k, threads)};
+        report(std::to_string(threads) + " threads", start, top);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::size_t k = defaultTopCount;
+    unsigned threadCount = 0;
+    std::size_t benchmarkElves = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+
+        if ((arg == "--threads") && (i + 1 < argc)) {
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if ((arg == "--bench") && (i + 1 < argc)) {
+            benchmarkElves = std::stoull(argv[++i]);
+        }
+        else if (!arg.empty() && std::all_of(arg.begin(), arg.end(), ::isdigit)) {
+            k = std::stoull(arg);
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [K] [--threads N] [--bench ELVES]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (benchmarkElves > 0) {
+        unsigned maxThreads = (threadCount > 0)
+            ? threadCount
+            : std::max(1u, std::thread::hardware_concurrency());
+
+        benchmark(benchmarkElves, k, maxThreads);
+        return 0;
+    }
+
+    if (threadCount > 0) {
+        InputBuffer input(STDIN_FILENO);
+
+        std::cout
+            << parse_elves_parallel(input.bytes(), k, threadCount).get_calories()
+            << std::endl;
+
+        return 0;
+    }
 
     std::cout
-        << std::accumulate(
-            elves.rbegin(),
-            std::next(elves.rbegin(), 3),
-            0,
-            [](int t, const Elf & b){ return t + b.get_calories(); })
+        << parse_elves(std::cin, k).get_calories()
         << std::endl;
 
     return 0;
@@ -1,120 +1,364 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
-#include <map>
-#include <sstream>
+#include <random>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNEL 1
+#endif
+
+// Which part's total is printed when --both is not given.
+constexpr int part = 2;
+
 enum class Shape { rock, paper, scissors };
+enum class Outcome { lose, draw, win };
 
-std::map<char, Shape> char2Shape{
-    {'A', Shape::rock},
-    {'B', Shape::paper},
-    {'C', Shape::scissors},
-};
+constexpr int shapeScore(Shape shape)
+{
+    return static_cast<int>(shape) + 1;
+}
 
-std::map<Shape, int> shape2Score{
-    {Shape::rock, 1},
-    {Shape::paper, 2},
-    {Shape::scissors, 3},
-};
+constexpr int outcomeScore(Outcome outcome)
+{
+    return static_cast<int>(outcome) * 3;
+}
 
 #ifdef DEBUG
-std::map<Shape, std::string> shape2String{
-    {Shape::rock, "rock"},
-    {Shape::paper, "paper"},
-    {Shape::scissors, "scissors"},
-};
+constexpr std::array<const char *, 3> shapeNames{"rock", "paper", "scissors"};
+constexpr std::array<const char *, 3> outcomeNames{"lose", "draw", "win"};
 #endif
 
-enum class Outcome { win, lose, draw };
+constexpr Outcome judgeRound(Shape opponentShape, Shape myShape)
+{
+    if (myShape == opponentShape) {
+        return Outcome::draw;
+    }
 
-std::map<char, Outcome> char2Outcome{
-    {'X', Outcome::lose},
-    {'Y', Outcome::draw},
-    {'Z', Outcome::win},
-};
+    if (((myShape == Shape::rock) && (opponentShape == Shape::scissors)) ||
+        ((myShape == Shape::paper) && (opponentShape == Shape::rock)) ||
+        ((myShape == Shape::scissors) && (opponentShape == Shape::paper))) {
+        return Outcome::win;
+    }
+
+    return Outcome::lose;
+}
+
+constexpr Shape solveRound(Shape opponentShape, Outcome outcome)
+{
+    for (auto myShape : {Shape::rock, Shape::paper, Shape::scissors}) {
+        if (judgeRound(opponentShape, myShape) == outcome) {
+            return myShape;
+        }
+    }
+
+    return opponentShape;
+}
+
+// Score of every line "A X" .. "C Z", indexed by (A..C) * 3 + (X..Z). The
+// first part reads the second column as my shape, the second part as the
+// outcome I need. Tables are padded to 16 entries for byte shuffles.
+using ScoreTable = std::array<std::uint8_t, 16>;
+
+constexpr ScoreTable makeScoreTable(int whichPart)
+{
+    ScoreTable table{};
+
+    for (int left = 0; left < 3; ++left) {
+        for (int right = 0; right < 3; ++right) {
+            auto opponentShape = static_cast<Shape>(left);
+            auto myShape = static_cast<Shape>(right);
+            auto outcome = static_cast<Outcome>(right);
 
-std::map<Outcome, int> outcome2Score{
-    {Outcome::lose, 0},
-    {Outcome::draw, 3},
-    {Outcome::win, 6},
+            if (whichPart == 1) {
+                outcome = judgeRound(opponentShape, myShape);
+            }
+            else {
+                myShape = solveRound(opponentShape, outcome);
+            }
+
+            table[left * 3 + right] = shapeScore(myShape) + outcomeScore(outcome);
+        }
+    }
+
+    return table;
+}
+
+constexpr ScoreTable part1Scores = makeScoreTable(1);
+constexpr ScoreTable part2Scores = makeScoreTable(2);
+
+static_assert(part1Scores[0 * 3 + 1] == 8);  // A Y
+static_assert(part2Scores[0 * 3 + 1] == 4);  // A Y
+
+struct Totals
+{
+    std::uint64_t part1 = 0;
+    std::uint64_t part2 = 0;
 };
 
+// Scores the line starting at bytes[pos] and returns the position after it.
+std::size_t scoreLine(std::string_view bytes, std::size_t pos, Totals & totals)
+{
+    auto end = bytes.find('\n', pos);
+    auto line = bytes.substr(pos, (end == std::string_view::npos) ? end : end - pos);
+
+    if (!line.empty() && (line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+
+    if ((line.size() != 3) ||
+        (line[0] < 'A') || (line[0] > 'C') ||
+        (line[1] != ' ') ||
+        (line[2] < 'X') || (line[2] > 'Z')) {
+        std::cerr << "unable to parse line: \"" << line << "\"" << std::endl;
+        std::terminate();
+    }
+
+    auto index = (line[0] - 'A') * 3 + (line[2] - 'X');
+
 #ifdef DEBUG
-std::map<Outcome, std::string> outcome2String{
-    {Outcome::lose, "lose"},
-    {Outcome::draw, "draw"},
-    {Outcome::win, "win"},
-};
+    auto opponentShape = static_cast<Shape>(line[0] - 'A');
+    auto myShape = static_cast<Shape>(line[2] - 'X');
+    auto outcome = static_cast<Outcome>(line[2] - 'X');
+
+    if (part == 1) {
+        outcome = judgeRound(opponentShape, myShape);
+    }
+    else {
+        myShape = solveRound(opponentShape, outcome);
+    }
+
+    std::cout
+        << shapeNames[static_cast<int>(myShape)] << " v "
+        << shapeNames[static_cast<int>(opponentShape)]
+        << " => " << outcomeNames[static_cast<int>(outcome)]
+        << " = " << static_cast<int>((part == 1) ? part1Scores[index] : part2Scores[index])
+        << std::endl;
 #endif
 
-std::map<std::pair<Shape, Outcome>, Shape> solutionTable{
-    // (opponentShape, outcome) => myShape
-    {std::make_pair(Shape::rock, Outcome::win), Shape::paper},
-    {std::make_pair(Shape::rock, Outcome::lose), Shape::scissors},
-    {std::make_pair(Shape::paper, Outcome::win), Shape::scissors},
-    {std::make_pair(Shape::paper, Outcome::lose), Shape::rock},
-    {std::make_pair(Shape::scissors, Outcome::win), Shape::rock},
-    {std::make_pair(Shape::scissors, Outcome::lose), Shape::paper},
-};
+    totals.part1 += part1Scores[index];
+    totals.part2 += part2Scores[index];
+
+    return (end == std::string_view::npos) ? bytes.size() : end + 1;
+}
 
-Shape solveRound(Shape opponentShape, Outcome outcome)
+void scoreScalar(std::string_view bytes, Totals & totals)
 {
-    if (outcome == Outcome::draw) {
-        return opponentShape;
+    for (std::size_t pos = 0; pos < bytes.size();) {
+        pos = scoreLine(bytes, pos, totals);
     }
-
-    return solutionTable.at(std::make_pair(opponentShape, outcome));
 }
 
-std::vector<std::pair<Shape, Outcome>> parseGuide()
+#ifdef HAVE_X86_KERNEL
+// Scores 16 well-formed four byte lines at a time. Each 32-bit lane holds
+// one line; its table index is built in the low byte and looked up with a
+// byte shuffle. Blocks that are not all "[A-C] [X-Z]\n" are left to
+// scoreLine, which also resynchronises after irregular lines.
+__attribute__((target("avx2")))
+void scoreAvx2(std::string_view bytes, Totals & totals)
 {
-    std::vector<std::pair<Shape, Outcome>> rounds;
+    const __m256i base = _mm256_set1_epi32('A' | (' ' << 8) | ('X' << 16) | ('\n' << 24));
+    const __m256i limit = _mm256_set1_epi32(2 | (2 << 16));
+    const __m256i lowByte = _mm256_set1_epi32(0xff);
+    const __m256i table1 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(part1Scores.data())));
+    const __m256i table2 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(part2Scores.data())));
+
+    __m256i sum1 = _mm256_setzero_si256();
+    __m256i sum2 = _mm256_setzero_si256();
 
-    for (std::string line; std::getline(std::cin, line);) {
-        std::pair<Shape, Outcome> round;
+    std::size_t pos = 0;
 
-        std::istringstream iss(line);
-        std::string left, right;
-        iss >> left >> right;
-        round.first = char2Shape.at(left[0]);
-        round.second = char2Outcome.at(right[0]);
-        
-        rounds.push_back(round);
+    while (pos < bytes.size()) {
+        if (bytes.size() - pos >= 64) {
+            auto block = reinterpret_cast<const __m256i *>(bytes.data() + pos);
+            auto offsets1 = _mm256_sub_epi8(_mm256_loadu_si256(block), base);
+            auto offsets2 = _mm256_sub_epi8(_mm256_loadu_si256(block + 1), base);
+
+            // Every byte offset must be within (2, 0, 2, 0) of "A X\n".
+            auto inRange = _mm256_and_si256(
+                _mm256_cmpeq_epi8(_mm256_max_epu8(offsets1, limit), limit),
+                _mm256_cmpeq_epi8(_mm256_max_epu8(offsets2, limit), limit));
+
+            if (_mm256_movemask_epi8(inRange) == -1) {
+                // index = 3 * left + right, in the low byte of each lane.
+                auto first = _mm256_and_si256(_mm256_add_epi8(
+                    _mm256_add_epi8(_mm256_add_epi8(offsets1, offsets1), offsets1),
+                    _mm256_srli_epi32(offsets1, 16)), lowByte);
+                auto second = _mm256_and_si256(_mm256_add_epi8(
+                    _mm256_add_epi8(_mm256_add_epi8(offsets2, offsets2), offsets2),
+                    _mm256_srli_epi32(offsets2, 16)), lowByte);
+
+                auto zero = _mm256_setzero_si256();
+                auto score1 = _mm256_add_epi8(
+                    _mm256_and_si256(_mm256_shuffle_epi8(table1, first), lowByte),
+                    _mm256_and_si256(_mm256_shuffle_epi8(table1, second), lowByte));
+                auto score2 = _mm256_add_epi8(
+                    _mm256_and_si256(_mm256_shuffle_epi8(table2, first), lowByte),
+                    _mm256_and_si256(_mm256_shuffle_epi8(table2, second), lowByte));
+
+                sum1 = _mm256_add_epi64(sum1, _mm256_sad_epu8(score1, zero));
+                sum2 = _mm256_add_epi64(sum2, _mm256_sad_epu8(score2, zero));
+                pos += 64;
+                continue;
+            }
+        }
+
+        pos = scoreLine(bytes, pos, totals);
     }
 
-    return rounds;
+    alignas(32) std::array<std::uint64_t, 4> lanes;
+
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes.data()), sum1);
+    totals.part1 += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes.data()), sum2);
+    totals.part2 += lanes[0] + lanes[1] + lanes[2] + lanes[3];
 }
+#endif
 
-int calcScore(const std::vector<std::pair<Shape, Outcome>> & rounds)
+enum class Kernel { scalar, avx2 };
+
+Kernel selectKernel()
 {
-    int totalScore = 0;
+#if defined(HAVE_X86_KERNEL) && !defined(DEBUG)
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernel::avx2;
+    }
+#endif
 
-    for (const auto & round : rounds) {
-        auto opponentShape = round.first;
-        auto outcome = round.second;
-        auto myShape = solveRound(opponentShape, outcome);
+    return Kernel::scalar;
+}
 
-#ifdef DEBUG
-        std::cout
-            << shape2String.at(myShape) << " v " << shape2String.at(opponentShape)
-            << " => " << outcome2String.at(outcome)
-            << " = " << shape2Score.at(myShape) + outcome2Score.at(outcome)
-            << std::endl;
+void scoreBytes(std::string_view bytes, Totals & totals, Kernel kernel)
+{
+#ifdef HAVE_X86_KERNEL
+    if (kernel == Kernel::avx2) {
+        scoreAvx2(bytes, totals);
+        return;
+    }
 #endif
 
-        totalScore += shape2Score.at(myShape) + outcome2Score.at(outcome);
+    scoreScalar(bytes, totals);
+}
+
+// Scores the guide for both parts in one pass, reading fixed-size buffers
+// and carrying any partial line over to the next one.
+Totals scoreGuide(std::istream & is, Kernel kernel)
+{
+    Totals totals;
+    std::vector<char> buffer(1 << 16);
+    std::size_t carried = 0;
+
+    while (is.read(buffer.data() + carried, buffer.size() - carried) || (is.gcount() > 0)) {
+        std::string_view bytes{buffer.data(), carried + static_cast<std::size_t>(is.gcount())};
+        auto complete = bytes.rfind('\n');
+
+        if (complete == std::string_view::npos) {
+            carried = bytes.size();
+
+            if (carried == buffer.size()) {
+                buffer.resize(buffer.size() * 2);
+            }
+
+            continue;
+        }
+
+        scoreBytes(bytes.substr(0, complete + 1), totals, kernel);
+
+        carried = bytes.size() - (complete + 1);
+        std::copy(bytes.begin() + complete + 1, bytes.end(), buffer.begin());
+    }
+
+    if (carried > 0) {
+        scoreBytes({buffer.data(), carried}, totals, kernel);
     }
 
-    return totalScore;
+    return totals;
 }
 
-int main()
+std::string generateGuide(std::size_t roundCount)
 {
-    auto rounds = parseGuide();
-    auto score = calcScore(rounds);
+    std::mt19937 rng{2};
+    std::uniform_int_distribution<int> columnDist{0, 2};
+    std::string guide;
 
-    std::cout << score << std::endl;
+    guide.reserve(roundCount * 4);
+
+    for (std::size_t round = 0; round < roundCount; ++round) {
+        guide += static_cast<char>('A' + columnDist(rng));
+        guide += ' ';
+        guide += static_cast<char>('X' + columnDist(rng));
+        guide += '\n';
+    }
+
+    return guide;
+}
+
+void benchmark(std::size_t roundCount)
+{
+    auto guide{generateGuide(roundCount)};
+
+    auto run = [&](const std::string & name, Kernel kernel) {
+        Totals totals;
+        auto start{std::chrono::steady_clock::now()};
+        scoreBytes(guide, totals, kernel);
+        std::chrono::duration<double> seconds{std::chrono::steady_clock::now() - start};
+
+        std::cout << std::setw(8) << std::left << name
+                  << std::setw(12) << totals.part1
+                  << std::setw(12) << totals.part2
+                  << std::fixed << std::setprecision(3)
+                  << guide.size() / seconds.count() / 1e9 << " GB/s" << std::endl;
+    };
+
+    std::cout << roundCount << " rounds" << std::endl;
+
+    run("scalar", Kernel::scalar);
+
+    if (selectKernel() == Kernel::avx2) {
+        run("avx2", Kernel::avx2);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    bool both = false;
+    std::size_t benchmarkRounds = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+
+        if (arg == "--both") {
+            both = true;
+        }
+        else if ((arg == "--bench") && (i + 1 < argc)) {
+            benchmarkRounds = std::stoull(argv[++i]);
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [--both] [--bench ROUNDS]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (benchmarkRounds > 0) {
+        benchmark(benchmarkRounds);
+        return 0;
+    }
+
+    auto totals = scoreGuide(std::cin, selectKernel());
+
+    if (both) {
+        std::cout << totals.part1 << std::endl << totals.part2 << std::endl;
+    }
+    else {
+        std::cout << ((part == 1) ? totals.part1 : totals.part2) << std::endl;
+    }
 
     return 0;
 }
@@ -1,108 +1,337 @@
 #include <array>
-#include <cctype>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
 #include <limits>
-#include <memory>
+#include <random>
+#include <sstream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 
-int itemValue(char item) {
-    if (std::isupper(item)) {
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNEL 1
+#endif
+
+constexpr int itemValue(char item) {
+    if ((item >= 'A') && (item <= 'Z')) {
         return item - 'A' + 27;
-    } else if (std::islower(item)) {
+    } else if ((item >= 'a') && (item <= 'z')) {
         return item - 'a' + 1;
     } else {
         return std::numeric_limits<int>::lowest();
     }
 }
 
-using Histogram = std::unordered_map<char, int>;
+// Set of item types, bit itemValue(item) for each item present. Bit 0
+// marks a character that is not an item.
+using ItemMask = std::uint64_t;
+
+constexpr ItemMask invalidItem = 1;
+
+// itemValue for every byte, or 0 for non-items, so building a mask takes
+// no branches.
+constexpr auto itemBits = []() {
+    std::array<std::uint8_t, 256> bits{};
+
+    for (int c = 0; c < 256; ++c) {
+        bits[c] = std::max(itemValue(static_cast<char>(c)), 0);
+    }
+
+    return bits;
+}();
+
+enum class Kernel { scalar, avx2 };
+
+Kernel selectKernel() {
+#if defined(HAVE_X86_KERNEL) && !defined(DEBUG)
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernel::avx2;
+    }
+#endif
+
+    return Kernel::scalar;
+}
+
+// Mask builder in use, picked once from the running CPU.
+Kernel itemMaskKernel = selectKernel();
+
+ItemMask itemMaskScalar(std::string_view items) {
+    ItemMask mask = 0;
+
+    for (char item : items) {
+        mask |= ItemMask{1} << itemBits[static_cast<unsigned char>(item)];
+    }
+
+    return mask;
+}
+
+#ifdef HAVE_X86_KERNEL
+// Same mapping as itemValue, 16 bytes at a time: each byte becomes its item
+// value (0 for non-items), groups of four are widened to 64-bit lanes and
+// shifted into one-hot masks, and the lanes are ORed together at the end.
+__attribute__((target("avx2")))
+ItemMask itemMaskAvx2(std::string_view items) {
+    const __m128i lowerBase = _mm_set1_epi8('a');
+    const __m128i upperBase = _mm_set1_epi8('A');
+    const __m128i lastOffset = _mm_set1_epi8(25);
+    const __m128i lowerFirst = _mm_set1_epi8(1);
+    const __m128i upperFirst = _mm_set1_epi8(27);
+    const __m256i one = _mm256_set1_epi64x(1);
+
+    __m256i masks = _mm256_setzero_si256();
+    auto data = items.data();
+    auto size = items.size();
+    std::size_t pos = 0;
+
+    for (; pos + 16 <= size; pos += 16) {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        auto lower = _mm_sub_epi8(bytes, lowerBase);
+        auto upper = _mm_sub_epi8(bytes, upperBase);
+        auto isLower = _mm_cmpeq_epi8(_mm_min_epu8(lower, lastOffset), lower);
+        auto isUpper = _mm_cmpeq_epi8(_mm_min_epu8(upper, lastOffset), upper);
+        auto values = _mm_or_si128(
+            _mm_and_si128(isLower, _mm_add_epi8(lower, lowerFirst)),
+            _mm_and_si128(isUpper, _mm_add_epi8(upper, upperFirst)));
+
+        masks = _mm256_or_si256(masks, _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(values)));
+        masks = _mm256_or_si256(masks, _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(_mm_srli_si128(values, 4))));
+        masks = _mm256_or_si256(masks, _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(_mm_srli_si128(values, 8))));
+        masks = _mm256_or_si256(masks, _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(_mm_srli_si128(values, 12))));
+    }
+
+    alignas(32) std::array<ItemMask, 4> lanes;
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes.data()), masks);
+
+    return lanes[0] | lanes[1] | lanes[2] | lanes[3] | itemMaskScalar(items.substr(pos));
+}
+#endif
+
+ItemMask itemMask(std::string_view items) {
+    ItemMask mask;
+
+#ifdef HAVE_X86_KERNEL
+    // Shorter runs of items are quicker to map one byte at a time.
+    if ((itemMaskKernel == Kernel::avx2) && (items.size() >= 16)) {
+        mask = itemMaskAvx2(items);
+    }
+    else
+#endif
+    {
+        mask = itemMaskScalar(items);
+    }
+
+    if ((mask & invalidItem) != 0) {
+        std::cerr << "invalid item in: \"" << items << "\"" << std::endl;
+        std::terminate();
+    }
+
+    return mask;
+}
+
+#ifdef DEBUG
+std::string maskItems(ItemMask mask) {
+    std::string items;
+
+    for (; mask != 0; mask &= mask - 1) {
+        auto value = std::countr_zero(mask);
+        items += static_cast<char>((value > 26) ? 'A' + value - 27 : 'a' + value - 1);
+    }
+
+    return items;
+}
+#endif
+
+// Calls visit with each line of the stream, read through one fixed buffer
+// so no line is copied or allocated.
+template <typename Visit>
+void forEachLine(std::istream & is, Visit visit) {
+    std::vector<char> buffer(1 << 16);
+    std::size_t carried = 0;
+
+    auto visitLine = [&visit](std::string_view line) {
+        if (!line.empty() && (line.back() == '\r')) {
+            line.remove_suffix(1);
+        }
+
+        visit(line);
+    };
+
+    while (is.read(buffer.data() + carried, buffer.size() - carried) || (is.gcount() > 0)) {
+        std::string_view bytes{buffer.data(), carried + static_cast<std::size_t>(is.gcount())};
+        std::size_t pos = 0;
+
+        for (auto end = bytes.find('\n'); end != std::string_view::npos; end = bytes.find('\n', pos)) {
+            visitLine(bytes.substr(pos, end - pos));
+            pos = end + 1;
+        }
+
+        carried = bytes.size() - pos;
+        std::copy(bytes.begin() + pos, bytes.end(), buffer.begin());
+
+        if (carried == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+
+    if (carried > 0) {
+        visitLine({buffer.data(), carried});
+    }
+}
+
+// Writes lineCount random rucksacks of 8 to maxItems items each.
+std::string generateRucksacks(std::size_t lineCount, int maxItems) {
+    constexpr std::string_view letters{"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+    std::mt19937 rng{3};
+    std::uniform_int_distribution<int> halfDist{4, std::max(4, maxItems / 2)};
+    std::uniform_int_distribution<std::size_t> itemDist{0, letters.size() - 1};
+    std::string rucksacks;
+
+    for (std::size_t line = 0; line < lineCount; ++line) {
+        for (int items = halfDist(rng) * 2; items > 0; --items) {
+            rucksacks += letters[itemDist(rng)];
+        }
+
+        rucksacks += '\n';
+    }
+
+    return rucksacks;
+}
 
 class Rucksack
 {
 private:
-    std::string _items;
-    std::shared_ptr<Histogram> _histogram;
+    ItemMask _items = 0;
 public:
-    explicit Rucksack(const std::string & items)
-        : _items{items}
-        , _histogram{std::make_shared<Histogram>()}
-    {
-        std::for_each(
-            _items.begin(),
-            _items.end(),
-            [this](char c){ ++((*_histogram)[c]); });
-    }
+    Rucksack() = default;
+    explicit Rucksack(std::string_view items)
+        : _items{itemMask(items)}
+    {}
     ~Rucksack() = default;
     auto get_items() const { return _items; }
-    auto get_histogram() const { return _histogram; }
 };
 
 constexpr int groupSize = 3;
-using RucksackGroupArray = std::array<std::shared_ptr<Rucksack>, groupSize>;
+using RucksackGroupArray = std::array<Rucksack, groupSize>;
 
 class Group
 {
-public:
-    static const int groupSize = 3; 
 private:
-    Histogram _histogram;
-    RucksackGroupArray _rucksacks;
-    char _commonItem;
+    int _commonItem;
 public:
-    explicit Group(RucksackGroupArray rucksacks)
-        : _rucksacks{rucksacks}
+    explicit Group(const RucksackGroupArray & rucksacks)
     {
-        for (const auto & rucksack : _rucksacks) {
-            for (const auto & [item, occurances] : *rucksack->get_histogram()) {
-                ++_histogram[item];
-            }
+        ItemMask common = ~ItemMask{0};
+
+        for (const auto & rucksack : rucksacks) {
+            common &= rucksack.get_items();
         }
 
-        for (const auto & [item, occurances] : _histogram) {
-            if (occurances == groupSize) {
-                _commonItem = item;
-                break;
-            }
+        if (common == 0) {
+            std::cerr << "group has no common item" << std::endl;
+            std::terminate();
         }
 
+        _commonItem = std::countr_zero(common);
+
 #ifdef DEBUG
             std::cout
-                << "rucksack[0] = " << _rucksacks[0]->get_items() << std::endl
-                << "rucksack[1] = " << _rucksacks[1]->get_items() << std::endl
-                << "rucksack[2] = " << _rucksacks[2]->get_items() << std::endl;
-
-            /*
-            std::cout << "~histogram~" << std::endl;
-            for (const auto & [item, occurances] : _histogram) {
-                std::cout << " - " << item << " = " << occurances << std::endl;
-            }
-            */
+                << "rucksack[0] = " << maskItems(rucksacks[0].get_items()) << std::endl
+                << "rucksack[1] = " << maskItems(rucksacks[1].get_items()) << std::endl
+                << "rucksack[2] = " << maskItems(rucksacks[2].get_items()) << std::endl;
 
             std::cout
-                << "~commonItem~ = " << _commonItem << " (" << itemValue(_commonItem) << ")" << std::endl
+                << "~commonItem~ = " << maskItems(common) << " (" << _commonItem << ")" << std::endl
                 << std::string(80, '-') << std::endl;
 #endif
 
     }
     ~Group() = default;
-    auto getScore() const { return itemValue(_commonItem); }
+    auto getScore() const { return _commonItem; }
 };
 
-int main()
-{
-    int score = 0, index = 0;
+long long processGroups(std::istream & is) {
+    long long score = 0;
+    int index = 0;
     RucksackGroupArray rucksacks;
 
-    for (std::string line; std::getline(std::cin, line); ++index) {
-        rucksacks[index % 3] = std::make_shared<Rucksack>(line);
+    forEachLine(is, [&](std::string_view line) {
+        rucksacks[index % groupSize] = Rucksack(line);
 
-        if (index % 3 == 2) {
+        if (index % groupSize == groupSize - 1) {
             score += Group(rucksacks).getScore();
         }
+
+        ++index;
+    });
+
+    return score;
+}
+
+// Writes lineCount rucksacks in groups of three sharing one badge item.
+std::string generateGroups(std::size_t lineCount, int maxItems) {
+    auto rucksacks{generateRucksacks(lineCount, maxItems)};
+    std::mt19937 rng{4};
+    std::uniform_int_distribution<int> badgeDist{0, 51};
+    std::size_t line = 0;
+    char badge = 'a';
+
+    // Put the group's badge at the front of each rucksack in the group.
+    for (std::size_t pos = 0; pos < rucksacks.size(); pos = rucksacks.find('\n', pos) + 1, ++line) {
+        if (line % groupSize == 0) {
+            auto value = badgeDist(rng);
+            badge = static_cast<char>((value < 26) ? 'a' + value : 'A' + value - 26);
+        }
+
+        rucksacks[pos] = badge;
+    }
+
+    return rucksacks;
+}
+
+// Times every mask kernel the CPU supports on the same generated input.
+void benchmark(std::size_t lineCount, int maxItems) {
+    auto rucksacks{generateGroups(lineCount, maxItems)};
+
+    std::cout << lineCount << " rucksacks, " << rucksacks.size() << " bytes" << std::endl;
+
+    for (auto kernel : {Kernel::scalar, selectKernel()}) {
+        std::istringstream iss{rucksacks};
+        itemMaskKernel = kernel;
+
+        auto start{std::chrono::steady_clock::now()};
+        auto score{processGroups(iss)};
+        std::chrono::duration<double> seconds{std::chrono::steady_clock::now() - start};
+
+        std::cout
+            << std::setw(8) << std::left << ((kernel == Kernel::avx2) ? "avx2" : "scalar")
+            << std::fixed << std::setprecision(1) << seconds.count() * 1000 << " ms, "
+            << rucksacks.size() / seconds.count() / 1e6 << " MB/s (" << score << ")"
+            << std::endl;
+
+        if (kernel == selectKernel()) {
+            break;
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    // "--bench N [ITEMS]" times N generated rucksacks of up to ITEMS items.
+    if ((argc > 2) && (std::string(argv[1]) == "--bench")) {
+        benchmark(std::stoull(argv[2]), (argc > 3) ? std::stoi(argv[3]) : 48);
+        return 0;
+    }
+
+    if ((argc > 1) && (std::string(argv[1]) == "--scalar")) {
+        itemMaskKernel = Kernel::scalar;
     }
 
-    std::cout << score << std::endl;
+    std::cout << processGroups(std::cin) << std::endl;
 
     return 0;
 }
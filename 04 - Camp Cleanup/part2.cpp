@@ -1,25 +1,54 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
-#include <regex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNEL 1
+#endif
+
+// Which part's count is printed when --both is not given.
+constexpr int part = 2;
+
+using Section = std::int32_t;
 
 class Range
 {
 private:
-    int _first, _last;
+    Section _first, _last;
 
 public:
-    Range(int first, int last)
+    Range(Section first, Section last)
         : _first(first)
         , _last(last)
     {}
 
     ~Range() = default;
 
-    bool inRange(int num) const
+    Section first() const { return _first; }
+    Section last() const { return _last; }
+    bool empty() const { return _first > _last; }
+
+    bool inRange(Section num) const
     {
         return (num >= _first) && (num <= _last);
     }
 
+    bool fullyContains(const Range & other) const
+    {
+        return ((inRange(other._first)) && (inRange(other._last)));
+    }
+
     bool overlaps(const Range & other) const
     {
         return ((inRange(other._first)) || (inRange(other._last)));
@@ -37,38 +66,592 @@ std::ostream & operator<<(std::ostream & os, const Range & range) {
 }
 #endif
 
-int main()
+// Static centered interval tree over a set of ranges. Each node keeps the
+// ranges containing its center twice, sorted by first (ascending) and by
+// last (descending), so a stabbing query reads only ranges it reports plus
+// one per level: O(log n + k). Overlap queries combine a stabbing query at
+// the query's first section with a binary search over all ranges sorted by
+// first. Empty ranges (first > last) contain nothing and are left out.
+// Visitors receive each range with its position in the input vector.
+class IntervalIndex
+{
+private:
+    using RangeId = std::uint32_t;
+
+    // Ranges [begin, end) of _byFirst and _byLast contain center. The
+    // smallest first and largest last among them let a query skip the node
+    // without touching those lists.
+    struct Node
+    {
+        Section center;
+        Section minFirst, maxLast;
+        RangeId begin, end;
+        std::int32_t left, right;
+    };
+
+    std::vector<Range> _ranges;
+    std::vector<std::size_t> _sources;
+    std::vector<Node> _nodes;
+    std::vector<RangeId> _byFirst, _byLast;
+    std::vector<RangeId> _allByFirst;
+    std::vector<Section> _allFirsts;
+
+    std::int32_t build(std::vector<RangeId> ids)
+    {
+        if (ids.empty()) {
+            return -1;
+        }
+
+        std::vector<Section> endpoints;
+        endpoints.reserve(ids.size() * 2);
+
+        for (auto id : ids) {
+            endpoints.push_back(_ranges[id].first());
+            endpoints.push_back(_ranges[id].last());
+        }
+
+        auto median = endpoints.begin() + endpoints.size() / 2;
+        std::nth_element(endpoints.begin(), median, endpoints.end());
+        auto center = *median;
+
+        std::vector<RangeId> leftIds, rightIds;
+        RangeId begin = _byFirst.size();
+
+        for (auto id : ids) {
+            if (_ranges[id].last() < center) {
+                leftIds.push_back(id);
+            }
+            else if (_ranges[id].first() > center) {
+                rightIds.push_back(id);
+            }
+            else {
+                _byFirst.push_back(id);
+                _byLast.push_back(id);
+            }
+        }
+
+        RangeId end = _byFirst.size();
+
+        std::sort(_byFirst.begin() + begin, _byFirst.end(), [this](RangeId a, RangeId b) {
+            return _ranges[a].first() < _ranges[b].first();
+        });
+        std::sort(_byLast.begin() + begin, _byLast.end(), [this](RangeId a, RangeId b) {
+            return _ranges[a].last() > _ranges[b].last();
+        });
+
+        auto node = static_cast<std::int32_t>(_nodes.size());
+        _nodes.push_back({center, _ranges[_byFirst[begin]].first(), _ranges[_byLast[begin]].last(), begin, end, -1, -1});
+
+        auto left = build(std::move(leftIds));
+        auto right = build(std::move(rightIds));
+        _nodes[node].left = left;
+        _nodes[node].right = right;
+
+        return node;
+    }
+
+public:
+    explicit IntervalIndex(const std::vector<Range> & ranges)
+    {
+        for (std::size_t i = 0; i < ranges.size(); ++i) {
+            if (!ranges[i].empty()) {
+                _ranges.push_back(ranges[i]);
+                _sources.push_back(i);
+            }
+        }
+
+        std::vector<RangeId> ids(_ranges.size());
+        std::iota(ids.begin(), ids.end(), 0);
+
+        _allByFirst = ids;
+        std::sort(_allByFirst.begin(), _allByFirst.end(), [this](RangeId a, RangeId b) {
+            return _ranges[a].first() < _ranges[b].first();
+        });
+
+        for (auto id : _allByFirst) {
+            _allFirsts.push_back(_ranges[id].first());
+        }
+
+        build(std::move(ids));
+    }
+
+    ~IntervalIndex() = default;
+
+    // Calls visit with every range containing section.
+    template <typename Visit>
+    void forEachContaining(Section section, Visit visit) const
+    {
+        for (std::int32_t node = _nodes.empty() ? -1 : 0; node != -1;) {
+            const auto & current = _nodes[node];
+
+            if (section < current.center) {
+                for (auto i = current.begin; (section >= current.minFirst) && (i < current.end); ++i) {
+                    if (_ranges[_byFirst[i]].first() > section) {
+                        break;
+                    }
+
+                    visit(_ranges[_byFirst[i]], _sources[_byFirst[i]]);
+                }
+
+                node = current.left;
+            }
+            else if (section > current.center) {
+                for (auto i = current.begin; (section <= current.maxLast) && (i < current.end); ++i) {
+                    if (_ranges[_byLast[i]].last() < section) {
+                        break;
+                    }
+
+                    visit(_ranges[_byLast[i]], _sources[_byLast[i]]);
+                }
+
+                node = current.right;
+            }
+            else {
+                for (auto i = current.begin; i < current.end; ++i) {
+                    visit(_ranges[_byFirst[i]], _sources[_byFirst[i]]);
+                }
+
+                break;
+            }
+        }
+    }
+
+    // Calls visit with every range sharing at least one section with query.
+    template <typename Visit>
+    void forEachOverlapping(const Range & query, Visit visit) const
+    {
+        if (query.empty()) {
+            return;
+        }
+
+        forEachContaining(query.first(), visit);
+
+        auto i = std::upper_bound(_allFirsts.begin(), _allFirsts.end(), query.first()) - _allFirsts.begin();
+
+        for (; (i < static_cast<std::ptrdiff_t>(_allFirsts.size())) && (_allFirsts[i] <= query.last()); ++i) {
+            visit(_ranges[_allByFirst[i]], _sources[_allByFirst[i]]);
+        }
+    }
+
+    std::size_t countContaining(Section section) const
+    {
+        std::size_t count = 0;
+        forEachContaining(section, [&count](const Range &, std::size_t) { ++count; });
+        return count;
+    }
+
+    std::size_t countOverlapping(const Range & query) const
+    {
+        std::size_t count = 0;
+        forEachOverlapping(query, [&count](const Range &, std::size_t) { ++count; });
+        return count;
+    }
+};
+
+// Assignment pairs in structure-of-arrays form, one array per bound.
+struct RangePairs
+{
+    std::vector<Section> firstA, lastA, firstB, lastB;
+
+    std::size_t size() const { return firstA.size(); }
+
+    Range rangeA(std::size_t i) const { return {firstA[i], lastA[i]}; }
+    Range rangeB(std::size_t i) const { return {firstB[i], lastB[i]}; }
+};
+
+struct Counts
+{
+    std::size_t fullyContain = 0;
+    std::size_t overlap = 0;
+};
+
+// Reads the section number at the front of text, followed by separator
+// when one is given.
+std::optional<Section> consumeSection(std::string_view & text, char separator)
 {
-    int numOverlaps = 0;
+    Section value = 0;
+    std::size_t digits = 0;
 
-    for (std::string line; std::getline(std::cin, line);) {
-        const std::regex regex("([0-9]+)-([0-9]+),([0-9]+)-([0-9]+)");
-        std::smatch matches;
+    for (; (digits < text.size()) && (text[digits] >= '0') && (text[digits] <= '9'); ++digits) {
+        if (digits == 9) {
+            return std::nullopt;
+        }
+
+        value = value * 10 + (text[digits] - '0');
+    }
+
+    if (digits == 0) {
+        return std::nullopt;
+    }
+
+    text.remove_prefix(digits);
+
+    if (separator != '\0') {
+        if (text.empty() || (text.front() != separator)) {
+            return std::nullopt;
+        }
+
+        text.remove_prefix(1);
+    }
+
+    return value;
+}
+
+// Parses "a-b,c-d" lines; returns false after reporting a malformed line.
+bool parsePairs(std::istream & is, RangePairs & pairs)
+{
+    for (std::string line; std::getline(is, line);) {
+        std::string_view text{line};
 
-        if (std::regex_search(line, matches, regex)) {
-            const Range rangeA(std::stoi(matches[1]), std::stoi(matches[2]));
-            const Range rangeB(std::stoi(matches[3]), std::stoi(matches[4]));
+        if (!text.empty() && (text.back() == '\r')) {
+            text.remove_suffix(1);
+        }
+
+        auto firstA = consumeSection(text, '-');
+        auto lastA = consumeSection(text, ',');
+        auto firstB = consumeSection(text, '-');
+        auto lastB = consumeSection(text, '\0');
+
+        if (!firstA || !lastA || !firstB || !lastB || !text.empty()) {
+            std::cerr << "error parsing line: " << line << std::endl;
+            return false;
+        }
+
+        pairs.firstA.push_back(*firstA);
+        pairs.lastA.push_back(*lastA);
+        pairs.firstB.push_back(*firstB);
+        pairs.lastB.push_back(*lastB);
+    }
+
+    return true;
+}
+
+// Every elf's assignment, both ranges of each pair.
+std::vector<Range> allRanges(const RangePairs & pairs)
+{
+    std::vector<Range> ranges;
+    ranges.reserve(pairs.size() * 2);
+
+    for (std::size_t i = 0; i < pairs.size(); ++i) {
+        ranges.push_back(pairs.rangeA(i));
+        ranges.push_back(pairs.rangeB(i));
+    }
+
+    return ranges;
+}
+
+// Number of pairs with at least one assignment overlapping query, given an
+// index built from allRanges; a pair is counted once even when both of its
+// ranges overlap.
+std::size_t countOverlappingPairs(const IntervalIndex & index, const Range & query)
+{
+    std::vector<std::size_t> hits;
+
+    index.forEachOverlapping(query, [&hits](const Range &, std::size_t source) {
+        hits.push_back(source / 2);
+    });
+
+    std::sort(hits.begin(), hits.end());
+    return std::unique(hits.begin(), hits.end()) - hits.begin();
+}
+
+void countScalar(const RangePairs & pairs, std::size_t begin, Counts & counts)
+{
+    for (std::size_t i = begin; i < pairs.size(); ++i) {
+        const auto rangeA = pairs.rangeA(i);
+        const auto rangeB = pairs.rangeB(i);
 
 #ifdef DEBUG
-            std::cout
-                << rangeA << " & " << rangeB << std::endl
-                << ((rangeA.overlaps(rangeB)) ? "YES" : "NO") << ", "
-                << ((rangeB.overlaps(rangeA)) ? "YES" : "NO") << std::endl
-                << std::string(80, '-') << std::endl;
+        std::cout
+            << rangeA << " & " << rangeB << std::endl
+            << ((rangeA.fullyContains(rangeB)) ? "YES" : "NO") << ", "
+            << ((rangeB.fullyContains(rangeA)) ? "YES" : "NO") << ", "
+            << ((rangeA.overlaps(rangeB)) ? "YES" : "NO") << ", "
+            << ((rangeB.overlaps(rangeA)) ? "YES" : "NO") << std::endl
+            << std::string(80, '-') << std::endl;
+#endif
+
+        counts.fullyContain += rangeA.fullyContains(rangeB) || rangeB.fullyContains(rangeA);
+        counts.overlap += rangeA.overlaps(rangeB) || rangeB.overlaps(rangeA);
+    }
+}
+
+#ifdef HAVE_X86_KERNEL
+// Evaluates Range::fullyContains and Range::overlaps in both directions for
+// eight pairs at a time. Lanes hold "x is outside the range" masks, so a
+// pair is counted when its lane is clear:
+//   contains = !((outFirstB | outLastB) & (outFirstA | outLastA))
+//   overlaps = !(outFirstB & outLastB & outFirstA & outLastA)
+__attribute__((target("avx2,popcnt")))
+void countAvx2(const RangePairs & pairs, Counts & counts)
+{
+    std::size_t i = 0;
+
+    for (; i + 8 <= pairs.size(); i += 8) {
+        auto firstA = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pairs.firstA.data() + i));
+        auto lastA = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pairs.lastA.data() + i));
+        auto firstB = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pairs.firstB.data() + i));
+        auto lastB = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pairs.lastB.data() + i));
+
+        auto outFirstB = _mm256_or_si256(_mm256_cmpgt_epi32(firstA, firstB), _mm256_cmpgt_epi32(firstB, lastA));
+        auto outLastB = _mm256_or_si256(_mm256_cmpgt_epi32(firstA, lastB), _mm256_cmpgt_epi32(lastB, lastA));
+        auto outFirstA = _mm256_or_si256(_mm256_cmpgt_epi32(firstB, firstA), _mm256_cmpgt_epi32(firstA, lastB));
+        auto outLastA = _mm256_or_si256(_mm256_cmpgt_epi32(firstB, lastA), _mm256_cmpgt_epi32(lastA, lastB));
+
+        auto notContains = _mm256_and_si256(
+            _mm256_or_si256(outFirstB, outLastB),
+            _mm256_or_si256(outFirstA, outLastA));
+        auto notOverlaps = _mm256_and_si256(
+            _mm256_and_si256(outFirstB, outLastB),
+            _mm256_and_si256(outFirstA, outLastA));
+
+        counts.fullyContain += 8 - _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(notContains)));
+        counts.overlap += 8 - _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(notOverlaps)));
+    }
+
+    countScalar(pairs, i, counts);
+}
+#endif
+
+enum class Kernel { scalar, avx2 };
+
+Kernel selectKernel()
+{
+#if defined(HAVE_X86_KERNEL) && !defined(DEBUG)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return Kernel::avx2;
+    }
 #endif
 
-            if ((rangeA.overlaps(rangeB)) ||
-                (rangeB.overlaps(rangeA))) {
-                ++numOverlaps;
+    return Kernel::scalar;
+}
+
+// Counts both parts' answers in one pass over the pairs.
+Counts countPairs(const RangePairs & pairs, Kernel kernel)
+{
+    Counts counts;
+
+#ifdef HAVE_X86_KERNEL
+    if (kernel == Kernel::avx2) {
+        countAvx2(pairs, counts);
+        return counts;
+    }
+#endif
+
+    countScalar(pairs, 0, counts);
+    return counts;
+}
+
+std::string generatePairs(std::size_t pairCount)
+{
+    std::mt19937 rng{4};
+    std::uniform_int_distribution<Section> sectionDist{1, 99};
+    std::ostringstream oss;
+
+    for (std::size_t pair = 0; pair < pairCount; ++pair) {
+        auto a = sectionDist(rng), b = sectionDist(rng), c = sectionDist(rng), d = sectionDist(rng);
+
+        oss << std::min(a, b) << "-" << std::max(a, b) << ","
+            << std::min(c, d) << "-" << std::max(c, d) << "\n";
+    }
+
+    return oss.str();
+}
+
+void benchmark(std::size_t pairCount)
+{
+    std::istringstream iss{generatePairs(pairCount)};
+    RangePairs pairs;
+
+    auto start{std::chrono::steady_clock::now()};
+    parsePairs(iss, pairs);
+    std::chrono::duration<double, std::milli> parseTime{std::chrono::steady_clock::now() - start};
+
+    std::cout << pairCount << " pairs, parse: "
+              << std::fixed << std::setprecision(1) << parseTime.count() << " ms" << std::endl;
+
+    for (auto kernel : {Kernel::scalar, selectKernel()}) {
+        start = std::chrono::steady_clock::now();
+        auto counts{countPairs(pairs, kernel)};
+        std::chrono::duration<double, std::milli> countTime{std::chrono::steady_clock::now() - start};
+
+        std::cout << std::setw(8) << std::left << ((kernel == Kernel::avx2) ? "avx2" : "scalar")
+                  << std::setw(12) << counts.fullyContain
+                  << std::setw(12) << counts.overlap
+                  << countTime.count() << " ms" << std::endl;
+
+        if (kernel == selectKernel()) {
+            break;
+        }
+    }
+}
+
+// Times stabbing and overlap queries against the interval index, and
+// against a linear scan for a sample of them to check the counts.
+void indexBenchmark(std::size_t rangeCount, std::size_t queryCount)
+{
+    constexpr Section sections = 1000000000;
+    constexpr std::size_t linearQueries = 100;
+
+    std::mt19937 rng{47};
+    std::uniform_int_distribution<Section> sectionDist{1, sections};
+    std::uniform_int_distribution<Section> lengthDist{0, sections / static_cast<Section>(rangeCount)};
+    std::vector<Range> ranges;
+    std::vector<Range> queries;
+
+    for (std::size_t i = 0; i < rangeCount; ++i) {
+        auto first = sectionDist(rng);
+        ranges.emplace_back(first, first + lengthDist(rng));
+    }
+
+    for (std::size_t i = 0; i < queryCount; ++i) {
+        auto first = sectionDist(rng);
+        queries.emplace_back(first, first + lengthDist(rng));
+    }
+
+    auto report = [](const std::string & name, auto start, std::size_t count, std::size_t found) {
+        std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+        std::cout << std::setw(16) << std::left << name
+                  << std::setw(12) << found
+                  << std::fixed << std::setprecision(1) << elapsed.count() * 1e6 / count << " ns/query" << std::endl;
+    };
+
+    auto start{std::chrono::steady_clock::now()};
+    IntervalIndex index(ranges);
+    std::chrono::duration<double, std::milli> buildTime{std::chrono::steady_clock::now() - start};
+
+    std::cout << rangeCount << " ranges, built in "
+              << std::fixed << std::setprecision(1) << buildTime.count() << " ms" << std::endl;
+
+    std::size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto & query : queries) {
+        found += index.countContaining(query.first());
+    }
+    report("stab", start, queryCount, found);
+
+    found = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto & query : queries) {
+        found += index.countOverlapping(query);
+    }
+    report("overlap", start, queryCount, found);
+
+    auto sample = std::min(queryCount, linearQueries);
+    std::size_t indexed = 0, linear = 0;
+
+    for (std::size_t i = 0; i < sample; ++i) {
+        indexed += index.countOverlapping(queries[i]);
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < sample; ++i) {
+        for (const auto & range : ranges) {
+            linear += range.overlaps(queries[i]) || queries[i].overlaps(range);
+        }
+    }
+    report("linear overlap", start, sample, linear);
+
+    if (linear != indexed) {
+        std::cerr << "index found " << indexed << " overlaps, linear scan " << linear << std::endl;
+        std::terminate();
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    bool both = false;
+    std::size_t benchmarkPairs = 0;
+    std::size_t indexBenchmarkRanges = 0;
+    std::optional<Section> stabSection;
+    std::optional<Range> overlapQuery;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+
+        if (arg == "--both") {
+            both = true;
+        }
+        else if ((arg == "--bench") && (i + 1 < argc)) {
+            benchmarkPairs = std::stoull(argv[++i]);
+        }
+        else if ((arg == "--index-bench") && (i + 1 < argc)) {
+            indexBenchmarkRanges = std::stoull(argv[++i]);
+        }
+        else if ((arg == "--stab") && (i + 1 < argc)) {
+            std::string_view text{argv[++i]};
+            stabSection = consumeSection(text, '\0');
+
+            if (!stabSection || !text.empty()) {
+                usage = true;
+            }
+        }
+        else if ((arg == "--overlap") && (i + 1 < argc)) {
+            std::string_view text{argv[++i]};
+            auto first = consumeSection(text, '-');
+            auto last = consumeSection(text, '\0');
+
+            if (first && last && text.empty()) {
+                overlapQuery = Range(*first, *last);
+            }
+            else {
+                usage = true;
             }
         }
         else {
-            std::cerr << "error parsing line: " << line << std::endl;
+            usage = true;
+        }
+
+        if (usage) {
+            std::cerr << "usage: " << argv[0]
+                      << " [--both] [--stab SECTION] [--overlap FIRST-LAST]"
+                      << " [--bench PAIRS] [--index-bench RANGES]" << std::endl;
             return 1;
         }
     }
 
-    std::cout << numOverlaps << std::endl;
+    if (benchmarkPairs > 0) {
+        benchmark(benchmarkPairs);
+        return 0;
+    }
+
+    if (indexBenchmarkRanges > 0) {
+        indexBenchmark(indexBenchmarkRanges, 1000000);
+        return 0;
+    }
+
+    RangePairs pairs;
+
+    if (!parsePairs(std::cin, pairs)) {
+        return 1;
+    }
+
+    // Query mode: count the elves assigned to a section, or the pairs with
+    // an elf assigned to any section of a range, instead of solving the
+    // puzzle.
+    if (stabSection || overlapQuery) {
+        IntervalIndex index(allRanges(pairs));
+
+        if (stabSection) {
+            std::cout << index.countContaining(*stabSection) << std::endl;
+        }
+
+        if (overlapQuery) {
+            std::cout << countOverlappingPairs(index, *overlapQuery) << std::endl;
+        }
+
+        return 0;
+    }
+
+    auto counts = countPairs(pairs, selectKernel());
+
+    if (both) {
+        std::cout << counts.fullyContain << std::endl << counts.overlap << std::endl;
+    }
+    else {
+        std::cout << ((part == 1) ? counts.fullyContain : counts.overlap) << std::endl;
+    }
     
     return 0;
 }
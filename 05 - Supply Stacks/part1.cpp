@@ -1,11 +1,43 @@
 #include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <random>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 
+// Consumes prefix from the front of s, returning whether it was there.
+bool consumePrefix(std::string_view & s, std::string_view prefix)
+{
+    if (s.substr(0, prefix.size()) != prefix) {
+        return false;
+    }
+
+    s.remove_prefix(prefix.size());
+    return true;
+}
+
+// Consumes a run of digits from the front of s into value.
+bool consumeNumber(std::string_view & s, int & value)
+{
+    std::size_t length = 0;
+    value = 0;
+
+    while ((length < s.size()) && (s[length] >= '0') && (s[length] <= '9')) {
+        value = value * 10 + (s[length] - '0');
+        ++length;
+    }
+
+    s.remove_prefix(length);
+    return length > 0;
+}
+
 class CraneInstruction
 {
 private:
@@ -13,23 +45,50 @@ private:
     int _sourceIndex;
     int _destinationIndex;
 
+    CraneInstruction()
+        : _quantity(-1)
+        , _sourceIndex(-1)
+        , _destinationIndex(-1)
+    {}
+
 public:
-    explicit CraneInstruction(std::string s)
+    // Parses "move Q from S to D" with prefix checks and an integer scanner.
+    explicit CraneInstruction(std::string_view s)
+        : CraneInstruction()
+    {
+        std::string_view rest{s};
+
+        if (!consumePrefix(rest, "move ") ||
+            !consumeNumber(rest, _quantity) ||
+            !consumePrefix(rest, " from ") ||
+            !consumeNumber(rest, _sourceIndex) ||
+            !consumePrefix(rest, " to ") ||
+            !consumeNumber(rest, _destinationIndex) ||
+            !rest.empty()) {
+            std::cerr << "error parsing crane instruction: " << s << std::endl;
+            _quantity = -1;
+            _sourceIndex = -1;
+            _destinationIndex = -1;
+        }
+    }
+
+    // Previous regex parser, kept as the benchmark baseline.
+    static CraneInstruction fromRegex(const std::string & s)
     {
         const std::regex regex("move (\\d+) from (\\d+) to (\\d+)");
         std::smatch matches;
+        CraneInstruction instruction;
 
         if (std::regex_search(s, matches, regex)) {
-            _quantity = std::stoi(matches[1]);
-            _sourceIndex = std::stoi(matches[2]);
-            _destinationIndex = std::stoi(matches[3]);
+            instruction._quantity = std::stoi(matches[1]);
+            instruction._sourceIndex = std::stoi(matches[2]);
+            instruction._destinationIndex = std::stoi(matches[3]);
         }
         else {
             std::cerr << "error parsing crane instruction: " << s << std::endl;
-            _quantity = -1;
-            _sourceIndex = -1;
-            _destinationIndex = -1;
         }
+
+        return instruction;
     }
 
     auto quantity()         const { return _quantity;         }
@@ -42,11 +101,22 @@ public:
 class CraneAndCrateStacks
 {
 private:
-    std::vector<std::deque<char>> _crateStacks;
+    // Each stack is stored bottom to top.
+    std::vector<std::vector<char>> _crateStacks;
+
+    std::vector<char> & stack(int index)
+    {
+        if ((index < 1) || (index > static_cast<int>(_crateStacks.size()))) {
+            std::cerr << "no crate stack " << index << std::endl;
+            std::terminate();
+        }
+
+        return _crateStacks[index - 1];
+    }
 
 public:
-    explicit CraneAndCrateStacks(std::vector<std::deque<char>> && crateStacks)
-        : _crateStacks(crateStacks)
+    explicit CraneAndCrateStacks(std::vector<std::vector<char>> && crateStacks)
+        : _crateStacks(std::move(crateStacks))
     {}
 
     void executeInstructions(const std::vector<CraneInstruction> & craneInstructions)
@@ -55,29 +125,114 @@ public:
 #ifdef DEBUG
             std::cout
                 << "current state:" << std::endl
-                << *this;
+                << *this
+                << "moving " << instruction.quantity()
+                << " from " << instruction.sourceIndex()
+                << " to " << instruction.destinationIndex()
+                << std::endl;
 #endif
-            for (int i = 0; i < instruction.quantity(); ++i) {
-                auto crate = _crateStacks[instruction.sourceIndex() - 1].back();
-#ifdef DEBUG
-                std::cout
-                    << "moving " << crate
-                    << " from " << instruction.sourceIndex()
-                    << " to " << instruction.destinationIndex()
-                    << std::endl;
-#endif
-                _crateStacks[instruction.sourceIndex() - 1].pop_back();
-                _crateStacks[instruction.destinationIndex() - 1].push_back(crate);
+            auto & source = stack(instruction.sourceIndex());
+            auto & destination = stack(instruction.destinationIndex());
+            auto quantity = static_cast<std::size_t>(instruction.quantity());
+
+            if (quantity > source.size()) {
+                std::cerr << "not enough crates to move " << quantity
+                          << " from " << instruction.sourceIndex() << std::endl;
+                std::terminate();
+            }
+
+            // Lifting crates off a stack and setting them back leaves it as is.
+            if (&source == &destination) {
+                continue;
+            }
+
+            // Crates come off one at a time, so the block lands reversed.
+            destination.insert(destination.end(),
+                               source.rbegin(),
+                               std::next(source.rbegin(), quantity));
+            source.resize(source.size() - quantity);
+        }
+    }
+
+    // Finds the final top crates without moving any, by following each
+    // final top position back through the instructions to the drawing.
+    std::string getTopCratesInReverse(const std::vector<CraneInstruction> & craneInstructions)
+        const
+    {
+        std::vector<std::size_t> heights;
+
+        for (const auto & crateStack : _crateStacks) {
+            heights.push_back(crateStack.size());
+        }
+
+        for (const auto & instruction : craneInstructions) {
+            auto source = instruction.sourceIndex() - 1;
+            auto destination = instruction.destinationIndex() - 1;
+            auto quantity = static_cast<std::size_t>(instruction.quantity());
+
+            if ((source < 0) || (source >= static_cast<int>(heights.size())) ||
+                (destination < 0) || (destination >= static_cast<int>(heights.size())) ||
+                (quantity > heights[source])) {
+                std::cerr << "invalid crane instruction: move " << quantity
+                          << " from " << source + 1 << " to " << destination + 1 << std::endl;
+                std::terminate();
+            }
+
+            heights[source] -= quantity;
+            heights[destination] += quantity;
+        }
+
+        std::string topCrates;
+
+        for (std::size_t top = 0; top < heights.size(); ++top) {
+            if (heights[top] == 0) {
+                continue;
+            }
+
+            // Stack and number of crates above the tracked crate.
+            int position = top;
+            std::size_t depth = 0;
+
+            for (auto iter = craneInstructions.rbegin(); iter != craneInstructions.rend(); ++iter) {
+                auto source = iter->sourceIndex() - 1;
+                auto destination = iter->destinationIndex() - 1;
+                auto quantity = static_cast<std::size_t>(iter->quantity());
+
+                // Moving crates onto their own stack changes nothing.
+                if (source == destination) {
+                    continue;
+                }
+
+                if (position == destination) {
+                    if (depth < quantity) {
+                        // Crates come off one at a time, reversing the block.
+                        position = source;
+                        depth = quantity - 1 - depth;
+                    }
+                    else {
+                        depth -= quantity;
+                    }
+                }
+                else if (position == source) {
+                    depth += quantity;
+                }
             }
+
+            const auto & crateStack = _crateStacks[position];
+            topCrates += crateStack[crateStack.size() - 1 - depth];
         }
+
+        return topCrates;
     }
 
     std::string getTopCrates() const
     {
         std::stringstream ss;
 
-        for (const auto & stack : _crateStacks) {
-            ss << stack.back();
+        for (const auto & crateStack : _crateStacks) {
+            if (!crateStack.empty()) {
+                ss << crateStack.back();
+            }
         }
 
         return ss.str();
@@ -119,45 +274,24 @@ public:
 
     CraneAndCrateStacks parseDrawing()
     {
-        const std::regex uppercase("[[:upper:]]");
-        const std::regex whitespaceOnly("^\\s+$");
-
-        // Determine the number of columns.
-        int numColumns = 0;
-        std::istringstream labelSS(_drawing.back());
-
-        for (std::string colLabel; std::getline(labelSS, colLabel, ' ');) {
-            if (colLabel.empty()) {
-                continue;
-            }
-
-            numColumns = std::stoi(colLabel);
-        }
+        // Columns are four characters wide ("[X] ") with the crate letter
+        // second, and the label line spans every column.
+        constexpr std::size_t columnCharWidth = 4;
+        std::size_t numColumns = (_drawing.back().size() + 2) / columnCharWidth;
 
-        // Parse crates into stacks.
-        constexpr int columnCharWidth = 5;
+        std::vector<std::vector<char>> crateStacks(numColumns);
 
-        std::vector<std::deque<char>> crateStacks(numColumns);
-
-        for (auto lineIterator = _drawing.begin();
-             lineIterator != std::prev(_drawing.end());
+        // Read bottom to top, skipping the label line.
+        for (auto lineIterator = std::next(_drawing.rbegin());
+             lineIterator != _drawing.rend();
              ++lineIterator) {
-            std::istringstream stackLineSS(*lineIterator);
-
-            for (int columnIndex = 0; columnIndex < numColumns; ++columnIndex) {
-                char columnCharArr[columnCharWidth];
-                stackLineSS.get(columnCharArr, columnCharWidth);
-                columnCharArr[columnCharWidth - 1] = '\0';
+            const auto & line = *lineIterator;
 
-                std::string columnString(columnCharArr);
-                std::smatch matches;
+            for (std::size_t columnIndex = 0; columnIndex < numColumns; ++columnIndex) {
+                auto position = columnIndex * columnCharWidth + 1;
 
-                if (std::regex_search(columnString, matches, uppercase)) {
-                    std::string columnCharString(matches[0]);
-                    crateStacks[columnIndex].push_front(columnCharString[0]);
-                }
-                else {
-                    continue;
+                if ((position < line.size()) && (line[position] >= 'A') && (line[position] <= 'Z')) {
+                    crateStacks[columnIndex].push_back(line[position]);
                 }
             }
         }
@@ -166,8 +300,50 @@ public:
     }
 };
 
-int main()
+// Times both instruction parsers over generated instruction lines.
+void benchmark(std::size_t lineCount)
+{
+    std::mt19937 rng{5};
+    std::uniform_int_distribution<int> quantityDist{1, 100000};
+    std::uniform_int_distribution<int> indexDist{1, 9};
+    std::vector<std::string> lines;
+
+    for (std::size_t i = 0; i < lineCount; ++i) {
+        lines.push_back("move " + std::to_string(quantityDist(rng))
+                        + " from " + std::to_string(indexDist(rng))
+                        + " to " + std::to_string(indexDist(rng)));
+    }
+
+    auto run = [&lines](const std::string & name, auto parse) {
+        auto start{std::chrono::steady_clock::now()};
+        long long checksum = 0;
+
+        for (const auto & line : lines) {
+            auto instruction{parse(line)};
+            checksum += instruction.quantity() + instruction.sourceIndex() + instruction.destinationIndex();
+        }
+
+        std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        std::cout << std::setw(8) << std::left << name
+                  << std::fixed << std::setprecision(0) << std::setw(14) << lines.size() / elapsed.count()
+                  << " lines/s (checksum " << checksum << ")" << std::endl;
+    };
+
+    run("regex", [](const std::string & line) { return CraneInstruction::fromRegex(line); });
+    run("scanner", [](const std::string & line) { return CraneInstruction(line); });
+}
+
+int main(int argc, char * argv[])
 {
+    // "--reverse" finds the top crates without moving any.
+    bool reverse = (argc > 1) && (std::string(argv[1]) == "--reverse");
+
+    // "--bench N" compares instruction parsers on N generated lines.
+    if ((argc > 2) && (std::string(argv[1]) == "--bench")) {
+        benchmark(std::stoull(argv[2]));
+        return 0;
+    }
+
     CrateStackDrawing crateStackDrawing;
     std::vector<CraneInstruction> craneInstructions;
 
@@ -184,7 +360,7 @@ int main()
             crateStackDrawing.addLine(line);
         }
         else if (parsingState == ParsingState::instructions) {
-            craneInstructions.push_back(CraneInstruction(line));
+            craneInstructions.emplace_back(line);
         }
         else {
             std::cerr << "bad parsing state" << std::endl;
@@ -193,6 +369,12 @@ int main()
     }
 
     auto cargo = crateStackDrawing.parseDrawing();
+
+    if (reverse) {
+        std::cout << cargo.getTopCratesInReverse(craneInstructions) << std::endl;
+        return 0;
+    }
+
     cargo.executeInstructions(craneInstructions);
 
     std::cout << cargo.getTopCrates() << std::endl;
@@ -1,46 +1,298 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
-#include <optional>
-#include <set>
+#include <limits>
+#include <random>
 #include <string>
-#include <utility>
+#include <string_view>
+#include <vector>
 
-constexpr int markerSize(14);
+constexpr std::size_t defaultMarkerSize(14);
 
-std::optional<std::pair<std::string, std::string::size_type>>
-findStartOfPacketMarker(std::string signal)
+// Largest marker a byte stream can hold: every byte value once.
+constexpr std::size_t maxMarkerSize(256);
+
+// Finds markers of several sizes in a stream of newline-separated signals,
+// fed in buffers of any size, in one pass and constant memory.
+//
+// For every byte value the scanner keeps the stream position just after its
+// last occurrence. The window [_windowBegin, _position) is the longest
+// suffix of the current signal without a repeat: when a byte was last seen
+// inside it, the window jumps past that occurrence. A marker of size k ends
+// wherever the window is at least k long, so all sizes share the same state.
+class MarkerScanner
 {
-    if (signal.size() < markerSize) {
-        return {};
+public:
+    using Offset = std::uint64_t;
+
+    static constexpr Offset notFound = std::numeric_limits<Offset>::max();
+
+    // Sizes must be between 1 and maxMarkerSize. With every set, each offset
+    // at which a marker ends is reported, not just the first per signal.
+    MarkerScanner(std::vector<std::size_t> sizes, bool every)
+        : _sizes(std::move(sizes))
+        , _every(every)
+    {
+        std::sort(_sizes.begin(), _sizes.end());
+        _sizes.erase(std::unique(_sizes.begin(), _sizes.end()), _sizes.end());
+        _nextSize = _sizes.empty() ? notFound : _sizes.front();
+    }
+
+    ~MarkerScanner() = default;
+
+    // Calls report(size, marker, offset) for markers ending in bytes, and
+    // report(size, "", notFound) for sizes a finished signal never reached.
+    // Offsets count from the start of the signal, one past the marker.
+    template <typename Report>
+    void feed(std::string_view bytes, Report report)
+    {
+        while (!bytes.empty()) {
+            auto end = bytes.find('\n');
+            scanSignal(bytes.substr(0, end), report);
+
+            if (end == std::string_view::npos) {
+                break;
+            }
+
+            endSignal(report);
+            bytes.remove_prefix(end + 1);
+        }
+    }
+
+    // Ends the last signal when the stream did not end with a newline.
+    template <typename Report>
+    void finish(Report report)
+    {
+        if (_position > _signalBegin) {
+            endSignal(report);
+        }
+    }
+
+private:
+    // Scans part of one signal, keeping the state in locals. Markers are read
+    // back from bytes, or from _recent for the part before this buffer, so
+    // _recent is only refreshed once at the end.
+    template <typename Report>
+    void scanSignal(std::string_view bytes, Report & report)
+    {
+        auto nextAfterLastSeen = _nextAfterLastSeen.data();
+        auto position = _position;
+        auto windowBegin = _windowBegin;
+        auto nextSize = _nextSize;
+
+        _buffer = bytes;
+        _bufferBegin = position;
+
+        for (char c : bytes) {
+            auto index = static_cast<unsigned char>(c);
+
+            if (nextAfterLastSeen[index] > windowBegin) {
+                windowBegin = nextAfterLastSeen[index];
+            }
+
+            nextAfterLastSeen[index] = ++position;
+
+            if (position - windowBegin >= nextSize) {
+                _position = position;
+                reportMarkers(position - windowBegin, report);
+                nextSize = _nextSize;
+            }
+        }
+
+        _position = position;
+        _windowBegin = windowBegin;
+
+        for (auto i = bytes.size() - std::min(bytes.size(), maxMarkerSize); i < bytes.size(); ++i) {
+            _recent[(_bufferBegin + i) % maxMarkerSize] = bytes[i];
+        }
+    }
+
+    // Reports the markers ending at _position, given the window length.
+    // Kept out of line so the scan loop keeps its state in registers.
+    template <typename Report>
+    [[gnu::noinline]] void reportMarkers(Offset length, Report & report)
+    {
+        if (_every) {
+            for (std::size_t i = 0; (i < _sizes.size()) && (_sizes[i] <= length); ++i) {
+                reportMarker(_sizes[i], report);
+            }
+
+            return;
+        }
+
+        reportMarker(_sizes[_found++], report);
+        _nextSize = (_found < _sizes.size()) ? _sizes[_found] : notFound;
     }
 
-    for (auto iter = std::next(signal.begin(), markerSize);
-         iter < signal.end();
-         ++iter) {
-        auto begin = std::prev(iter, markerSize);
-        std::set unique(begin, iter);
+    template <typename Report>
+    void reportMarker(std::size_t size, Report & report)
+    {
+        std::string marker(size, '\0');
 
-        if (unique.size() == markerSize) {
-            return {{{begin, iter}, std::distance(signal.begin(), iter)}};
+        for (std::size_t i = 0; i < size; ++i) {
+            auto position = _position - size + i;
+            marker[i] = (position >= _bufferBegin)
+                ? _buffer[position - _bufferBegin]
+                : _recent[position % maxMarkerSize];
         }
+
+        report(size, std::string_view{marker}, _position - _signalBegin);
+    }
+
+    template <typename Report>
+    void endSignal(Report & report)
+    {
+        if (!_every) {
+            for (; _found < _sizes.size(); ++_found) {
+                report(_sizes[_found], std::string_view{}, notFound);
+            }
+        }
+
+        // Positions stay absolute, so starting the window here hides every
+        // byte seen in earlier signals without clearing the table.
+        _signalBegin = _position;
+        _windowBegin = _position;
+        _found = 0;
+        _nextSize = _sizes.empty() ? notFound : _sizes.front();
+    }
+
+    std::vector<std::size_t> _sizes;
+    bool _every;
+    std::array<Offset, 256> _nextAfterLastSeen{};
+    // Bytes of the current signal by stream position: the buffer being
+    // scanned, and the last maxMarkerSize bytes before it.
+    std::string_view _buffer;
+    Offset _bufferBegin = 0;
+    std::array<char, maxMarkerSize> _recent{};
+    Offset _position = 0;
+    Offset _signalBegin = 0;
+    Offset _windowBegin = 0;
+    std::size_t _found = 0;
+    // Smallest window length that has a marker left to report.
+    Offset _nextSize;
+};
+
+// Feeds the stream to the scanner in fixed-size buffers.
+template <typename Report>
+void scanStream(std::istream & is, MarkerScanner & scanner, Report report)
+{
+    std::array<char, 1 << 16> buffer;
+
+    while (is.read(buffer.data(), buffer.size()) || (is.gcount() > 0)) {
+        scanner.feed({buffer.data(), static_cast<std::size_t>(is.gcount())}, report);
     }
 
-    return {};
+    scanner.finish(report);
 }
 
-int main()
+// Writes a signal of length bytes whose only marker of markerSize ends it:
+// the body repeats within every markerSize window.
+std::string generateSignal(std::size_t length, std::size_t markerSize)
 {
-    for (std::string line; std::getline(std::cin, line);) {
-        auto location = findStartOfPacketMarker(line)
-            .value_or(std::make_pair("", -1));
-        
-        std::cout
-#ifdef DEBUG
-            << line
-#endif
-            << " => " << location.first
-            << " @ " << location.second
-            << std::endl;
+    std::mt19937 rng{6};
+    std::uniform_int_distribution<int> letterDist{0, static_cast<int>(markerSize) - 2};
+    std::string signal;
+
+    signal.reserve(length + 1);
+
+    for (std::size_t i = 0; i + markerSize < length; ++i) {
+        signal += static_cast<char>('a' + letterDist(rng));
+    }
+
+    for (std::size_t i = 0; i < markerSize; ++i) {
+        signal += static_cast<char>('a' + markerSize - 1 + i);
+    }
+
+    signal += '\n';
+    return signal;
+}
+
+void benchmark(std::size_t length, const std::vector<std::size_t> & sizes)
+{
+    auto signal{generateSignal(length, sizes.back())};
+    MarkerScanner scanner(sizes, false);
+    std::vector<MarkerScanner::Offset> offsets;
+    std::string_view bytes{signal};
+
+    auto start{std::chrono::steady_clock::now()};
+
+    for (std::size_t pos = 0; pos < bytes.size(); pos += 1 << 16) {
+        scanner.feed(bytes.substr(pos, 1 << 16), [&offsets](auto, auto, auto offset) {
+            offsets.push_back(offset);
+        });
+    }
+
+    std::chrono::duration<double> seconds{std::chrono::steady_clock::now() - start};
+
+    std::cout
+        << signal.size() << " bytes: "
+        << std::fixed << std::setprecision(3) << signal.size() / seconds.count() / 1e9 << " GB/s";
+
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+        std::cout << " (" << sizes[i] << " @ " << offsets[i] << ")";
+    }
+
+    std::cout << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+    std::vector<std::size_t> sizes;
+    std::size_t benchmarkLength = 0;
+    bool every = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+
+        if ((arg == "--bench") && (i + 1 < argc)) {
+            benchmarkLength = std::stoull(argv[++i]);
+        }
+        else if (arg == "--every") {
+            every = true;
+        }
+        else if (!arg.empty() &&
+                 (arg.find_first_not_of("0123456789") == std::string::npos) &&
+                 (arg.size() <= 3) &&
+                 (std::stoull(arg) > 0) && (std::stoull(arg) <= maxMarkerSize)) {
+            sizes.push_back(std::stoull(arg));
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [MARKER_SIZE...] [--every] [--bench LENGTH]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (sizes.empty()) {
+        sizes.push_back(defaultMarkerSize);
     }
 
+    std::sort(sizes.begin(), sizes.end());
+
+    if (benchmarkLength > 0) {
+        benchmark(benchmarkLength, sizes);
+        return 0;
+    }
+
+    // A single size keeps the original output; several prefix each result
+    // with its size.
+    bool labelled = (sizes.size() > 1);
+    MarkerScanner scanner(sizes, every);
+
+    scanStream(std::cin, scanner, [labelled](std::size_t size, std::string_view marker, MarkerScanner::Offset offset) {
+        if (labelled) {
+            std::cout << size;
+        }
+
+        std::cout
+            << " => " << marker
+            << " @ " << offset
+            << '\n';
+    });
+
+    std::cout.flush();
+
     return 0;
 }
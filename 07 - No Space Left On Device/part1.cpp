@@ -1,152 +1,255 @@
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
-#include <memory>
-#include <numeric>
+#include <limits>
 #include <optional>
-#include <regex>
+#include <random>
 #include <sstream>
+#include <stack>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using FileSize = std::size_t;
+using InodeIndex = std::size_t;
+using NameId = std::uint32_t;
 
-class File
-{
-private:
-    std::string _name;
-    FileSize _size;
+constexpr InodeIndex noInode = std::numeric_limits<InodeIndex>::max();
 
-public:
-    File()
-        : _name("")
-        , _size(0)
-    {}
-    
-    File(const std::string & name, FileSize size)
-        : _name(name)
-        , _size(size)
-    {}
+// Entry in the flat inode table.
+struct Inode
+{
+    NameId name;
+    InodeIndex parent;
+    bool isDirectory;
+    FileSize size;
+};
 
-    ~File() = default;
+// Hash allowing string_view lookups in string-keyed maps.
+struct NameHash
+{
+    using is_transparent = void;
 
-    auto name() const { return _name; }
-    auto size() const { return _size; }
+    std::size_t operator()(std::string_view name) const
+    {
+        return std::hash<std::string_view>{}(name);
+    }
 };
 
-class Directory;
-using DirectoryPtr = std::shared_ptr<Directory>;
-using DirectoryPtrConst = std::shared_ptr<const Directory>;
-
-class Directory
-    : public std::enable_shared_from_this<Directory>
+// Maps (directory inode, interned name, kind) to the child inode. A file and
+// a directory may share a name. Open addressing with linear probing over one
+// flat slot array, so adding a child allocates only when the table doubles;
+// free slots hold noInode as the child.
+class ChildIndex
 {
-public:
 private:
-    std::optional<DirectoryPtr> _parent;
-    std::string _name;
-    std::vector<DirectoryPtr> _directories;
-    std::vector<File> _files;
+    struct Slot
+    {
+        InodeIndex parent;
+        NameId name;
+        bool isDirectory;
+        InodeIndex child = noInode;
+    };
 
-public:
-    Directory()
-        : _parent(std::nullopt)
-        , _name("")
-    {}
+    std::vector<Slot> _slots;
+    std::size_t _count = 0;
+    unsigned _shift = 64;
 
-    Directory(DirectoryPtr parent,
-              const std::string & name)
-        : _parent({parent})
-        , _name(name)
-    {}
+    std::size_t slotOf(InodeIndex parent, NameId name, bool isDirectory) const
+    {
+        std::uint64_t entry = (std::uint64_t{name} << 1) | isDirectory;
+        return ((parent * 0x9e3779b97f4a7c15ULL ^ entry) * 0xbf58476d1ce4e5b9ULL) >> _shift;
+    }
 
-    ~Directory() = default;
+    static bool matches(const Slot & slot, InodeIndex parent, NameId name, bool isDirectory)
+    {
+        return (slot.parent == parent) && (slot.name == name) && (slot.isDirectory == isDirectory);
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        std::vector<Slot> slots(capacity);
+        std::swap(_slots, slots);
+        _shift = 64 - std::countr_zero(capacity);
 
-    auto parent() const { return _parent; }
-    auto name()   const { return _name;   }
+        for (const auto & slot : slots) {
+            if (slot.child != noInode) {
+                auto i = slotOf(slot.parent, slot.name, slot.isDirectory);
 
+                while (_slots[i].child != noInode) {
+                    i = (i + 1) & (capacity - 1);
+                }
 
-    std::optional<DirectoryPtr> getDirectory(const std::string & name)
+                _slots[i] = slot;
+            }
+        }
+    }
+
+public:
+    ChildIndex()
+    {
+        rehash(16);
+    }
+
+    ChildIndex(ChildIndex &&) = default;
+    ~ChildIndex() = default;
+
+    // Sizes the table for count children, keeping it at most half full.
+    void reserve(std::size_t count)
+    {
+        if (count * 2 > _slots.size()) {
+            rehash(std::bit_ceil(count * 2));
+        }
+    }
+
+    std::optional<InodeIndex> find(InodeIndex parent, NameId name, bool isDirectory)
         const
     {
-        auto found = std::find_if(
-            _directories.begin(),
-            _directories.end(),
-            [&name](auto dirPtr){ return name == dirPtr->name(); });
+        for (auto i = slotOf(parent, name, isDirectory); _slots[i].child != noInode; i = (i + 1) & (_slots.size() - 1)) {
+            if (matches(_slots[i], parent, name, isDirectory)) {
+                return _slots[i].child;
+            }
+        }
+
+        return std::nullopt;
+    }
 
-        if (found != _directories.end()) {
-            return {*found};
+    // Returns false, leaving the index as is, if parent already has a child
+    // of this kind with this name.
+    bool insert(InodeIndex parent, NameId name, bool isDirectory, InodeIndex child)
+    {
+        reserve(_count + 1);
+
+        auto i = slotOf(parent, name, isDirectory);
+
+        for (; _slots[i].child != noInode; i = (i + 1) & (_slots.size() - 1)) {
+            if (matches(_slots[i], parent, name, isDirectory)) {
+                return false;
+            }
         }
 
-        return {};
+        _slots[i] = {parent, name, isDirectory, child};
+        ++_count;
+        return true;
     }
+};
 
-    bool hasDirectory(const std::string & name)
-        const
+// File system held as a flat table of inodes. The root is inode 0 and every
+// inode is added after its parent, so a single backwards pass over the table
+// visits children before parents. Names are interned and children are found
+// through one flat hash index keyed on (parent, name, kind).
+class FileSystem
+{
+private:
+    std::vector<Inode> _inodes;
+    std::vector<std::string> _names;
+    std::unordered_map<std::string, NameId, NameHash, std::equal_to<>> _nameIds;
+    ChildIndex _children;
+
+    NameId intern(std::string_view name)
     {
-        return getDirectory(name).has_value();
+        auto found = _nameIds.find(name);
+
+        if (found != _nameIds.end()) {
+            return found->second;
+        }
+
+        NameId id = _names.size();
+        _names.emplace_back(name);
+        _nameIds.emplace(_names.back(), id);
+        return id;
     }
 
-    bool hasFile(const std::string & name)
-        const
+    std::optional<InodeIndex> addInode(InodeIndex parent, std::string_view name, bool isDirectory, FileSize size)
     {
-        auto found = std::find_if(
-            _files.begin(),
-            _files.end(),
-            [&name](const auto & file){ return name == file.name(); });
+        InodeIndex index = _inodes.size();
+        NameId nameId = intern(name);
+
+        if (!_children.insert(parent, nameId, isDirectory, index)) {
+            return std::nullopt;
+        }
 
-        return found != _files.end();
+        _inodes.push_back({nameId, parent, isDirectory, size});
+        return index;
     }
 
-    std::vector<DirectoryPtrConst> findAllDirectories()
-        const
+public:
+    static constexpr InodeIndex root = 0;
+
+    FileSystem()
+    {
+        _inodes.push_back({intern(""), noInode, true, 0});
+    }
+
+    FileSystem(FileSystem &&) = default;
+    ~FileSystem() = default;
+
+    // Makes room for count inodes without reallocating.
+    void reserve(std::size_t count)
     {
-        std::vector<DirectoryPtrConst> result;
-        std::vector<DirectoryPtrConst> queue{ shared_from_this() };
+        _inodes.reserve(count);
+        _children.reserve(count);
+    }
 
-        while (!queue.empty()) {
-            auto curr = queue.back();
-            queue.pop_back();
+    const Inode & inode(InodeIndex index) const { return _inodes[index]; }
+    const std::string & name(InodeIndex index) const { return _names[_inodes[index].name]; }
+    auto size() const { return _inodes.size(); }
 
-            result.push_back(curr);
+    std::optional<InodeIndex> getChild(InodeIndex directory, std::string_view name, bool isDirectory)
+        const
+    {
+        auto nameId = _nameIds.find(name);
 
-            std::for_each(
-                curr->_directories.begin(),
-                curr->_directories.end(),
-                [&queue](auto dirPtr){ queue.push_back(dirPtr); });
+        if (nameId == _nameIds.end()) {
+            return std::nullopt;
         }
 
-        return result;
+        return _children.find(directory, nameId->second, isDirectory);
+    }
+
+    // Adding an entry whose name is already taken by one of the same kind in
+    // parent does nothing and returns nullopt.
+    std::optional<InodeIndex> addDirectory(InodeIndex parent, std::string_view name)
+    {
+        return addInode(parent, name, true, 0);
     }
 
+    std::optional<InodeIndex> addFile(InodeIndex parent, std::string_view name, FileSize size)
+    {
+        return addInode(parent, name, false, size);
+    }
 
-    FileSize getTotalSize()
+    // Total size of every inode, computed in one post-order pass.
+    std::vector<FileSize> getTotalSizes()
         const
     {
-        auto filesSize = std::accumulate(
-            _files.begin(),
-            _files.end(),
-            0,
-            [](auto t, const auto & file){ return t + file.size(); });
-
-        auto directoriesSize = std::accumulate(
-            _directories.begin(),
-            _directories.end(),
-            0,
-            [](auto t, const auto & dirPtr){ return t + dirPtr->getTotalSize(); });
-
-        return filesSize + directoriesSize;
+        std::vector<FileSize> totals(_inodes.size());
+
+        for (InodeIndex index = _inodes.size(); index-- > 0;) {
+            totals[index] += _inodes[index].size;
+
+            if (index != root) {
+                totals[_inodes[index].parent] += totals[index];
+            }
+        }
+
+        return totals;
     }
 
 #ifdef DEBUG
-    std::string getPathString()
+    std::string getPathString(InodeIndex index)
         const
     {
-        auto currentDirectory = std::make_optional(shared_from_this());
         std::stack<std::string> pathComponents;
 
-        do {
-            pathComponents.push(currentDirectory.value()->name());
-            currentDirectory = currentDirectory.value()->parent();
-        } while (currentDirectory.has_value());
+        for (; index != noInode; index = _inodes[index].parent) {
+            pathComponents.push(name(index));
+        }
 
         std::stringstream ss;
 
@@ -158,67 +261,38 @@ public:
         return ss.str();
     }
 #endif
-
-    void addDirectory(std::string directory)
-    {
-#ifdef DEBUG
-        if (hasDirectory(directory)) {
-            std::cerr << "attempt to add an existing directory" << std::endl;
-            return;
-        }
-#endif
-
-        _directories.push_back(std::make_shared<Directory>(shared_from_this(), directory));
-    }
-
-    void addFile(std::string name, FileSize size)
-    {
-#ifdef DEBUG
-        if (hasFile(name)) {
-            std::cerr << "attempt to add an existing file" << std::endl;
-            return;
-        }
-#endif
-
-        _files.push_back({name, size});
-    }
 };
 
 class InputParser
 {
 private:
-    DirectoryPtr _fileSystemRoot;
-    DirectoryPtr _currentDirectory;
+    FileSystem _fileSystem;
+    InodeIndex _currentDirectory;
 
-    inline static const std::regex cd_cmd{"^\\$ cd ([[:alnum:]_\\./]+)$"};
-    inline static const std::regex ls_cmd{"^\\$ ls$"};
-    inline static const std::regex file_line{"^(\\d+) ([[:alnum:]_\\.]+)$"};
-    inline static const std::regex dir_line{"^dir ([[:alnum:]_\\.]+)$"};
-
-    void changeDirectory(const std::string & directory)
+    void changeDirectory(std::string_view directory)
     {
 #ifdef DEBUG
         std::cout << ">>> cd " << directory << std::endl;
 #endif
 
         if (directory == "/") {
-            _currentDirectory = _fileSystemRoot;
+            _currentDirectory = FileSystem::root;
             return;
         }
 
         if (directory == "..") {
-            auto parent = _currentDirectory->parent();
+            auto parent = _fileSystem.inode(_currentDirectory).parent;
 
-            if (!parent.has_value()) {
+            if (parent == noInode) {
                 std::cerr << "file system root has no parent directory" << std::endl;
                 std::terminate();
             }
 
-            _currentDirectory = parent.value();
+            _currentDirectory = parent;
             return;
         }
 
-        auto nextDirectory = _currentDirectory->getDirectory(directory);
+        auto nextDirectory = _fileSystem.getChild(_currentDirectory, directory, true);
 
         if (nextDirectory.has_value()) {
             _currentDirectory = nextDirectory.value();
@@ -236,88 +310,219 @@ private:
 #endif
     }
 
-    void addFile(const std::string & name, FileSize size)
+    void addFile(std::string_view name, FileSize size)
     {
 #ifdef DEBUG
         std::cout << name << " :: " << size << std::endl;
 #endif
 
-        _currentDirectory->addFile(name, size);
+        if (!_fileSystem.addFile(_currentDirectory, name, size).has_value()) {
+#ifdef DEBUG
+            std::cerr << "attempt to add an existing file" << std::endl;
+#endif
+        }
     }
 
-    void addDirectory(const std::string & name)
+    void addDirectory(std::string_view name)
     {
 #ifdef DEBUG
         std::cout << name << " :: DIRECTORY" << std::endl;
 #endif
 
-        _currentDirectory->addDirectory(name);
+        if (!_fileSystem.addDirectory(_currentDirectory, name).has_value()) {
+#ifdef DEBUG
+            std::cerr << "attempt to add an existing directory" << std::endl;
+#endif
+        }
+    }
+
+    // Removes prefix from the front of line if it is there.
+    static bool consumePrefix(std::string_view & line, std::string_view prefix)
+    {
+        if (!line.starts_with(prefix)) {
+            return false;
+        }
+
+        line.remove_prefix(prefix.size());
+        return true;
+    }
+
+    [[noreturn]] static void parseError(std::string_view line)
+    {
+        std::cerr << "unable to parse line: \"" << line << "\"" << std::endl;
+        std::terminate();
     }
 
-    void parseLine(std::string line)
+    void parseLine(std::string_view line)
     {
-        std::smatch matches;
+        auto rest = line;
 
-        if (std::regex_match(line, matches, cd_cmd)) {
-            changeDirectory(matches[1]);
+        if (consumePrefix(rest, "$ cd ")) {
+            if (rest.empty()) {
+                parseError(line);
+            }
+
+            changeDirectory(rest);
         }
-        else if (std::regex_match(line, matches, ls_cmd)) {
+        else if (rest == "$ ls") {
             listDirectoryContents();
         }
-        else if (std::regex_match(line, matches, file_line)) {
-            addFile(matches[2], std::stoi(matches[1]));
-        }
-        else if (std::regex_match(line, matches, dir_line)) {
-            addDirectory(matches[1]);
+        else if (consumePrefix(rest, "dir ")) {
+            if (rest.empty()) {
+                parseError(line);
+            }
+
+            addDirectory(rest);
         }
         else {
-            std::cerr << "unable to parse line: \"" << line << "\"" << std::endl;
-            std::terminate();
+            FileSize size = 0;
+            auto [end, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), size);
+
+            if ((ec != std::errc()) || (end == rest.data())) {
+                parseError(line);
+            }
+
+            rest.remove_prefix(end - rest.data());
+
+            if (!consumePrefix(rest, " ") || rest.empty()) {
+                parseError(line);
+            }
+
+            addFile(rest, size);
         }
     }
 public:
-    InputParser()
-        : _fileSystemRoot(std::make_shared<Directory>())
-    {}
+    // expectedEntries, when known, sizes the file system up front.
+    explicit InputParser(std::size_t expectedEntries = 0)
+        : _currentDirectory(FileSystem::root)
+    {
+        _fileSystem.reserve(expectedEntries + 1);
+    }
 
     ~InputParser() = default;
     
-    DirectoryPtr parseInput(std::istream & is)
+    FileSystem parseInput(std::istream & is)
     {
         for (std::string line; std::getline(is, line);) {
             parseLine(line);
         }
 
-        return _fileSystemRoot;
+        return std::move(_fileSystem);
     }
 };
 
 constexpr FileSize sizeLimit = 100000;
 
-FileSize getScore(const DirectoryPtr & fileSystemRoot)
+FileSize getScore(const FileSystem & fileSystem)
+{
+    auto totals = fileSystem.getTotalSizes();
+    FileSize score = 0;
+
+    for (InodeIndex index = 0; index < fileSystem.size(); ++index) {
+        if (fileSystem.inode(index).isDirectory && (totals[index] <= sizeLimit)) {
+            score += totals[index];
+        }
+    }
+
+    return score;
+}
+
+// Writes a random terminal session exploring a file system with roughly
+// entryCount files and directories.
+std::string generateSession(std::size_t entryCount)
 {
-    auto dirs = fileSystemRoot->findAllDirectories();
-
-    return std::accumulate(
-        dirs.begin(),
-        dirs.end(),
-        0,
-        [](FileSize t, auto dirPtr) {
-            auto dirSize = dirPtr->getTotalSize();
-            if (dirSize <= sizeLimit) {
-                return t + dirSize;
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<int> childDist{1, 12};
+    std::uniform_int_distribution<int> kindDist{0, 3};
+    std::uniform_int_distribution<FileSize> sizeDist{1, 300000};
+    std::uniform_int_distribution<int> stemDist{0, 255};
+    std::ostringstream oss;
+    std::size_t entries = 0;
+
+    // Subdirectories still to visit, per directory on the current path.
+    std::vector<std::vector<std::string>> pending;
+
+    auto listDirectory = [&]() {
+        std::vector<std::string> subdirectories;
+        int children = childDist(rng);
+
+        oss << "$ ls\n";
+
+        for (int i = 0; i < children && entries < entryCount; ++i, ++entries) {
+            // Names repeat across directories but never within one.
+            std::string name{"n" + std::to_string(stemDist(rng)) + "_" + std::to_string(i)};
+
+            // Every directory above the depth limit gets at least one
+            // subdirectory so the walk does not die out early.
+            bool lastChild = (i + 1 == children) || (entries + 1 == entryCount);
+
+            if ((pending.size() < 64) &&
+                ((kindDist(rng) == 0) || (lastChild && subdirectories.empty()))) {
+                oss << "dir " << name << "\n";
+                subdirectories.push_back(name);
+            }
+            else {
+                oss << sizeDist(rng) << " " << name << ".f\n";
+            }
+        }
+
+        pending.push_back(subdirectories);
+    };
+
+    oss << "$ cd /\n";
+    listDirectory();
+
+    while (!pending.empty()) {
+        if (pending.back().empty()) {
+            pending.pop_back();
+
+            if (!pending.empty()) {
+                oss << "$ cd ..\n";
             }
-            return t;
-        });
+
+            continue;
+        }
+
+        oss << "$ cd " << pending.back().back() << "\n";
+        pending.back().pop_back();
+        listDirectory();
+    }
+
+    return oss.str();
 }
 
+void benchmark(std::size_t entryCount)
+{
+    auto session{generateSession(entryCount)};
+    std::istringstream iss{session};
+
+    auto start{std::chrono::steady_clock::now()};
+    InputParser inputParser(entryCount);
+    auto fileSystem{inputParser.parseInput(iss)};
+    auto parsed{std::chrono::steady_clock::now()};
+    auto score{getScore(fileSystem)};
+    auto scored{std::chrono::steady_clock::now()};
+
+    std::chrono::duration<double, std::milli> parseTime{parsed - start};
+    std::chrono::duration<double, std::milli> scoreTime{scored - parsed};
+
+    std::cout << fileSystem.size() << " inodes, " << session.size() << " bytes" << std::endl
+              << "parse: " << parseTime.count() << " ms" << std::endl
+              << "score: " << scoreTime.count() << " ms (" << score << ")" << std::endl;
+}
 
-int main()
+int main(int argc, char * argv[])
 {
+    // "--bench N" times a generated session with about N entries.
+    if ((argc > 2) && (std::string(argv[1]) == "--bench")) {
+        benchmark(std::stoull(argv[2]));
+        return 0;
+    }
+
     InputParser inputParser;
-    DirectoryPtr fileSystemRoot(inputParser.parseInput(std::cin));
+    auto fileSystem(inputParser.parseInput(std::cin));
 
-    std::cout << getScore(fileSystemRoot) << std::endl;
+    std::cout << getScore(fileSystem) << std::endl;
 
     return 0;
 }
@@ -1,37 +1,133 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <iomanip>
 #include <iostream>
-#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 using Distance = int;
 using CoordinatePair = std::pair<Distance, Distance>;
 using Tree = std::uint8_t;
 
+constexpr int treeHeights = 10;
+
 std::ostream & operator<<(std::ostream & os, const CoordinatePair & coordinates)
 {
     return os << "(" << coordinates.first << ", " << coordinates.second << ")";
 }
 
+// Splits [0, count) into one contiguous chunk per thread and calls
+// work(chunk, begin, end) for each, running chunk 0 on the calling thread.
+template<typename Work>
+void parallelFor(Distance count, unsigned threadCount, Work work)
+{
+    auto chunkBegin = [&](unsigned chunk) {
+        return static_cast<Distance>(static_cast<std::int64_t>(count) * chunk / threadCount);
+    };
+
+    std::vector<std::thread> workers;
+
+    for (unsigned chunk = 1; chunk < threadCount; ++chunk) {
+        workers.emplace_back(work, chunk, chunkBegin(chunk), chunkBegin(chunk + 1));
+    }
+
+    work(0u, chunkBegin(0), chunkBegin(1));
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+}
+
 class Forest
 {
 private:
-    std::map<CoordinatePair, Tree> _treeMap;
+    // Tree heights in row-major order.
+    std::vector<Tree> _trees;
     Distance _height;
     Distance _width;
 
+    std::size_t index(Distance x, Distance y) const { return static_cast<std::size_t>(y) * _width + x; }
+    Tree tree(Distance x, Distance y) const { return _trees[index(x, y)]; }
+
+    static constexpr Distance tileSize = 64;
+
+    // Column-major copy of the forest, written in square tiles so column
+    // sweeps can run along contiguous memory.
+    std::vector<Tree> transposed(unsigned threadCount)
+        const
+    {
+        std::vector<Tree> columns(_trees.size());
+        Distance tileRows = (_height + tileSize - 1) / tileSize;
+
+        parallelFor(tileRows, threadCount, [&](unsigned, Distance begin, Distance end) {
+            for (Distance tileY = begin * tileSize; tileY < std::min(end * tileSize, _height); tileY += tileSize) {
+                for (Distance tileX = 0; tileX < _width; tileX += tileSize) {
+                    for (Distance y = tileY; y < std::min(tileY + tileSize, _height); ++y) {
+                        for (Distance x = tileX; x < std::min(tileX + tileSize, _width); ++x) {
+                            columns[static_cast<std::size_t>(x) * _height + y] = tree(x, y);
+                        }
+                    }
+                }
+            }
+        });
+
+        return columns;
+    }
+
+    // Calls merge(chunk, x, y) for every tree, tile by tile so row-major and
+    // column-major buffers are both read from cache.
+    template<typename Merge>
+    void forEachTiled(unsigned threadCount, Merge merge)
+        const
+    {
+        Distance tileRows = (_height + tileSize - 1) / tileSize;
+
+        parallelFor(tileRows, threadCount, [&](unsigned chunk, Distance begin, Distance end) {
+            for (Distance tileY = begin * tileSize; tileY < std::min(end * tileSize, _height); tileY += tileSize) {
+                for (Distance tileX = 0; tileX < _width; tileX += tileSize) {
+                    for (Distance y = tileY; y < std::min(tileY + tileSize, _height); ++y) {
+                        for (Distance x = tileX; x < std::min(tileX + tileSize, _width); ++x) {
+                            merge(chunk, x, y);
+                        }
+                    }
+                }
+            }
+        });
+    }
+
 public:
     explicit Forest(std::istream & is)
+        : _height(0)
+        , _width(0)
     {
         Distance y = 0;
 
         for (std::string line; std::getline(is, line); ++y) {
-            Distance x = 0;
+            if (!line.empty() && (line.back() == '\r')) {
+                line.pop_back();
+            }
+
+            if ((y > 0) && (static_cast<Distance>(line.size()) != _width)) {
+                std::cerr << "forest row " << y << " has width " << line.size()
+                          << ", expected " << _width << std::endl;
+                std::terminate();
+            }
 
             for (const auto & c : line) {
-                _treeMap[{x, y}] = c;
-                ++x;
+                if ((c < '0') || (c > '9')) {
+                    std::cerr << "invalid tree height '" << c << "' in forest row " << y << std::endl;
+                    std::terminate();
+                }
+
+                _trees.push_back(c - '0');
             }
 
-            _width = x;
+            _width = line.size();
         }
 
         _height = y;
@@ -42,13 +138,15 @@ public:
     Tree getTree(const CoordinatePair & coordinates)
         const
     {
-        try {
-            return _treeMap.at(coordinates);
-        }
-        catch (const std::out_of_range & oor) {
+        auto x = coordinates.first;
+        auto y = coordinates.second;
+
+        if ((x < 0) || (x >= _width) || (y < 0) || (y >= _height)) {
             std::cerr << "tree out of forest bounds: " << coordinates << std::endl;
             std::terminate();
         }
+
+        return tree(x, y);
     }
 
     bool onEdge(const CoordinatePair & coordinates)
@@ -63,95 +161,133 @@ public:
                 || (y == (_height - 1)));
     }
 
-    bool isVisible(const CoordinatePair & coordinates)
+    // Marks every tree taller than all trees between it and some edge,
+    // using a running maximum along each row and column in both directions.
+    std::vector<std::uint8_t> visibilityMap()
         const
     {
-        auto tree = getTree(coordinates);
-        auto x = coordinates.first;
-        auto y = coordinates.second;
+        std::vector<std::uint8_t> visible(_trees.size(), 0);
+        std::vector<int> columnMax(_width, -1);
+
+        // From the left, right and top.
+        for (Distance y = 0; y < _height; ++y) {
+            int rowMax = -1;
 
-        // Up
-        bool upVisible = true;
+            for (Distance x = 0; x < _width; ++x) {
+                int height = tree(x, y);
 
-        for (Distance yPrime = 0; yPrime < y; ++yPrime) {
-            if (getTree({x, yPrime}) >= tree) {
-                upVisible = false;
-                break;
+                if (height > rowMax) {
+                    visible[index(x, y)] = 1;
+                    rowMax = height;
+                }
+
+                if (height > columnMax[x]) {
+                    visible[index(x, y)] = 1;
+                    columnMax[x] = height;
+                }
             }
-        }
 
-        if (upVisible) {
-            return true;
-        }
+            rowMax = -1;
 
-        // Down
-        bool downVisible = true;
+            for (Distance x = _width - 1; (x >= 0) && (rowMax < treeHeights - 1); --x) {
+                int height = tree(x, y);
 
-        for (Distance yPrime = y + 1; yPrime < _height; ++yPrime) {
-            if (getTree({x, yPrime}) >= tree) {
-                downVisible = false;
-                break;
+                if (height > rowMax) {
+                    visible[index(x, y)] = 1;
+                    rowMax = height;
+                }
             }
         }
 
-        if (downVisible) {
-            return true;
-        }
+        // From the bottom.
+        std::fill(columnMax.begin(), columnMax.end(), -1);
 
-        // Left
-        bool leftVisible = true;
+        for (Distance y = _height - 1; y >= 0; --y) {
+            for (Distance x = 0; x < _width; ++x) {
+                int height = tree(x, y);
 
-        for (Distance xPrime = 0; xPrime < x; ++xPrime) {
-            if (getTree({xPrime, y}) >= tree) {
-                leftVisible = false;
-                break;
+                if (height > columnMax[x]) {
+                    visible[index(x, y)] = 1;
+                    columnMax[x] = height;
+                }
             }
         }
 
-        if (leftVisible) {
-            return true;
-        }
+        return visible;
+    }
+
+    std::size_t countVisible()
+        const
+    {
+        auto visible{visibilityMap()};
+        return std::count(visible.begin(), visible.end(), 1);
+    }
 
-        // Right
-        bool rightVisible = true;
+    // Marks trees visible from either end of a line of trees.
+    static void markVisibleLine(const Tree * line, Distance length, std::uint8_t * visible)
+    {
+        int highest = -1;
 
-        for (Distance xPrime = x + 1; xPrime < _width; ++xPrime) {
-            if (getTree({xPrime, y}) >= tree) {
-                rightVisible = false;
-                break;
+        for (Distance i = 0; (i < length) && (highest < treeHeights - 1); ++i) {
+            if (line[i] > highest) {
+                visible[i] = 1;
+                highest = line[i];
             }
         }
 
-        if (rightVisible) {
-            return true;
-        }
+        highest = -1;
 
-        return false;
+        for (Distance i = length - 1; (i >= 0) && (highest < treeHeights - 1); --i) {
+            if (line[i] > highest) {
+                visible[i] = 1;
+                highest = line[i];
+            }
+        }
     }
 
-    std::size_t countVisible()
+    // Runs the row sweeps and the column sweeps (over a transposed copy) on
+    // separate blocks per thread, then merges both results tile by tile.
+    std::size_t countVisibleParallel(unsigned threadCount)
         const
     {
-        auto counter = 0;
+        auto columns{transposed(threadCount)};
+        std::vector<std::uint8_t> rowVisible(_trees.size(), 0);
+        std::vector<std::uint8_t> columnVisible(_trees.size(), 0);
 
-        for (const auto & [coords, tree] : _treeMap) {
-            if (onEdge(coords) || isVisible(coords)) {
-                ++counter;
+        parallelFor(_height, threadCount, [&](unsigned, Distance begin, Distance end) {
+            for (Distance y = begin; y < end; ++y) {
+                markVisibleLine(&_trees[index(0, y)], _width, &rowVisible[index(0, y)]);
             }
-        }
+        });
+
+        parallelFor(_width, threadCount, [&](unsigned, Distance begin, Distance end) {
+            for (Distance x = begin; x < end; ++x) {
+                auto offset = static_cast<std::size_t>(x) * _height;
+                markVisibleLine(&columns[offset], _height, &columnVisible[offset]);
+            }
+        });
+
+        std::vector<std::size_t> counts(threadCount, 0);
 
-        return counter;
+        forEachTiled(threadCount, [&](unsigned chunk, Distance x, Distance y) {
+            counts[chunk] += rowVisible[index(x, y)]
+                | columnVisible[static_cast<std::size_t>(x) * _height + y];
+        });
+
+        return std::accumulate(counts.begin(), counts.end(), std::size_t{0});
     }
 
 #ifdef DEBUG
     void printVisibleMap()
     {
+        auto visible{visibilityMap()};
+
         for (Distance y = 0; y < _height; ++y) {
             for (Distance x = 0; x < _width; ++x) {
                 if (onEdge({x, y})) {
                     std::cout << "E";
                 }
-                else if (isVisible({x, y})) {
+                else if (visible[index(x, y)]) {
                     std::cout << ".";
                 }
                 else {
@@ -164,14 +300,85 @@ public:
 #endif
 };
 
-int main()
+// Writes a random square forest in the puzzle's input format.
+std::string generateForest(Distance size)
 {
+    std::mt19937 rng{8};
+    std::uniform_int_distribution<int> heightDist{0, treeHeights - 1};
+    std::string forest;
+    forest.reserve(static_cast<std::size_t>(size + 1) * size);
+
+    for (Distance y = 0; y < size; ++y) {
+        for (Distance x = 0; x < size; ++x) {
+            forest += static_cast<char>('0' + heightDist(rng));
+        }
+        forest += '\n';
+    }
+
+    return forest;
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned threadCount = 0;
+    Distance benchmarkSize = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+
+        if ((arg == "--threads") && (i + 1 < argc)) {
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if ((arg == "--bench") && (i + 1 < argc)) {
+            benchmarkSize = std::stoi(argv[++i]);
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [--threads N] [--bench SIZE]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Times a generated forest sequentially and with 1, 2, 4... threads.
+    if (benchmarkSize > 0) {
+        std::istringstream iss{generateForest(benchmarkSize)};
+        Forest forest(iss);
+        unsigned maxThreads = (threadCount > 0)
+            ? threadCount
+            : std::max(1u, std::thread::hardware_concurrency());
+
+        auto report = [](const std::string & name, auto start, auto result) {
+            std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+            std::cout << std::setw(12) << std::left << name
+                      << std::setw(12) << result
+                      << std::fixed << std::setprecision(1) << elapsed.count() << " ms" << std::endl;
+        };
+
+        std::cout << benchmarkSize << "x" << benchmarkSize << " forest" << std::endl;
+
+        auto start{std::chrono::steady_clock::now()};
+        auto result{forest.countVisible()};
+        report("sequential", start, result);
+
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            start = std::chrono::steady_clock::now();
+            result = forest.countVisibleParallel(threads);
+            report(std::to_string(threads) + " threads", start, result);
+        }
+
+        return 0;
+    }
+
     Forest forest(std::cin);
 
 #ifdef DEBUG
     forest.printVisibleMap();
 #endif
 
+    if (threadCount > 0) {
+        std::cout << forest.countVisibleParallel(threadCount) << std::endl;
+        return 0;
+    }
+
     std::cout << forest.countVisible() << std::endl;
 
     return 0;
@@ -1,40 +1,136 @@
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
-#include <map>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 using Distance = int;
 using CoordinatePair = std::pair<Distance, Distance>;
 using Tree = std::uint8_t;
 
+constexpr int treeHeights = 10;
+
 std::ostream & operator<<(std::ostream & os, const CoordinatePair & coordinates)
 {
     return os << "(" << coordinates.first << ", " << coordinates.second << ")";
 }
 
+// Splits [0, count) into one contiguous chunk per thread and calls
+// work(chunk, begin, end) for each, running chunk 0 on the calling thread.
+template<typename Work>
+void parallelFor(Distance count, unsigned threadCount, Work work)
+{
+    auto chunkBegin = [&](unsigned chunk) {
+        return static_cast<Distance>(static_cast<std::int64_t>(count) * chunk / threadCount);
+    };
+
+    std::vector<std::thread> workers;
+
+    for (unsigned chunk = 1; chunk < threadCount; ++chunk) {
+        workers.emplace_back(work, chunk, chunkBegin(chunk), chunkBegin(chunk + 1));
+    }
+
+    work(0u, chunkBegin(0), chunkBegin(1));
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+}
+
 class Forest
 {
 private:
-    std::map<CoordinatePair, Tree> _treeMap;
+    // Tree heights in row-major order.
+    std::vector<Tree> _trees;
     Distance _height;
     Distance _width;
 
+    std::size_t index(Distance x, Distance y) const { return static_cast<std::size_t>(y) * _width + x; }
+    Tree tree(Distance x, Distance y) const { return _trees[index(x, y)]; }
+
+    static constexpr Distance tileSize = 64;
+
+    // Column-major copy of the forest, written in square tiles so column
+    // sweeps can run along contiguous memory.
+    std::vector<Tree> transposed(unsigned threadCount)
+        const
+    {
+        std::vector<Tree> columns(_trees.size());
+        Distance tileRows = (_height + tileSize - 1) / tileSize;
+
+        parallelFor(tileRows, threadCount, [&](unsigned, Distance begin, Distance end) {
+            for (Distance tileY = begin * tileSize; tileY < std::min(end * tileSize, _height); tileY += tileSize) {
+                for (Distance tileX = 0; tileX < _width; tileX += tileSize) {
+                    for (Distance y = tileY; y < std::min(tileY + tileSize, _height); ++y) {
+                        for (Distance x = tileX; x < std::min(tileX + tileSize, _width); ++x) {
+                            columns[static_cast<std::size_t>(x) * _height + y] = tree(x, y);
+                        }
+                    }
+                }
+            }
+        });
+
+        return columns;
+    }
+
+    // Calls merge(chunk, x, y) for every tree, tile by tile so row-major and
+    // column-major buffers are both read from cache.
+    template<typename Merge>
+    void forEachTiled(unsigned threadCount, Merge merge)
+        const
+    {
+        Distance tileRows = (_height + tileSize - 1) / tileSize;
+
+        parallelFor(tileRows, threadCount, [&](unsigned chunk, Distance begin, Distance end) {
+            for (Distance tileY = begin * tileSize; tileY < std::min(end * tileSize, _height); tileY += tileSize) {
+                for (Distance tileX = 0; tileX < _width; tileX += tileSize) {
+                    for (Distance y = tileY; y < std::min(tileY + tileSize, _height); ++y) {
+                        for (Distance x = tileX; x < std::min(tileX + tileSize, _width); ++x) {
+                            merge(chunk, x, y);
+                        }
+                    }
+                }
+            }
+        });
+    }
+
 public:
     explicit Forest(std::istream & is)
+        : _height(0)
+        , _width(0)
     {
         Distance y = 0;
 
         for (std::string line; std::getline(is, line); ++y) {
-            Distance x = 0;
+            if (!line.empty() && (line.back() == '\r')) {
+                line.pop_back();
+            }
+
+            if ((y > 0) && (static_cast<Distance>(line.size()) != _width)) {
+                std::cerr << "forest row " << y << " has width " << line.size()
+                          << ", expected " << _width << std::endl;
+                std::terminate();
+            }
 
             for (const auto & c : line) {
-                _treeMap[{x, y}] = c;
-                ++x;
+                if ((c < '0') || (c > '9')) {
+                    std::cerr << "invalid tree height '" << c << "' in forest row " << y << std::endl;
+                    std::terminate();
+                }
+
+                _trees.push_back(c - '0');
             }
 
-            _width = x;
+            _width = line.size();
         }
 
         _height = y;
@@ -45,13 +141,15 @@ public:
     Tree getTree(const CoordinatePair & coordinates)
         const
     {
-        try {
-            return _treeMap.at(coordinates);
-        }
-        catch (const std::out_of_range & oor) {
+        auto x = coordinates.first;
+        auto y = coordinates.second;
+
+        if ((x < 0) || (x >= _width) || (y < 0) || (y >= _height)) {
             std::cerr << "tree out of forest bounds: " << coordinates << std::endl;
             std::terminate();
         }
+
+        return tree(x, y);
     }
 
     bool onEdge(const CoordinatePair & coordinates)
@@ -66,83 +164,140 @@ public:
                 || (y == (_height - 1)));
     }
 
-    Distance scenicScore(const CoordinatePair & coordinates)
+    using Score = std::uint64_t;
+    using ViewDistance = std::uint16_t;
+
+    // Viewing distances are kept in ViewDistance, and the parallel sweeps
+    // keep the product of two of them in 32 bits; both need every side to
+    // fit.
+    void checkViewDistances()
         const
     {
-        auto tree = getTree(coordinates);
-
-        if (onEdge(coordinates)) {
-            return 0;
+        if ((_width > std::numeric_limits<ViewDistance>::max()) ||
+            (_height > std::numeric_limits<ViewDistance>::max())) {
+            std::cerr << "forest too large for viewing distances" << std::endl;
+            std::terminate();
         }
+    }
 
-        auto x = coordinates.first;
-        auto y = coordinates.second;
+    // Calls visit(x, y, score) for every tree. Viewing distances come from
+    // remembering, per height, where the last tree at least that tall was
+    // seen along each sweep, so each tree costs O(treeHeights).
+    template<typename Visitor>
+    void forEachScenicScore(Visitor visit)
+        const
+    {
+        checkViewDistances();
 
-        // Up
-        auto upScore = 0;
+        // Sweep down the columns for the distance looking up.
+        std::vector<ViewDistance> upDistances(_trees.size());
+        std::vector<Distance> columnLast(static_cast<std::size_t>(_width) * treeHeights, 0);
 
-        for (Distance yPrime = y - 1; yPrime >= 0; --yPrime) {
-            ++upScore;
+        for (Distance y = 0; y < _height; ++y) {
+            for (Distance x = 0; x < _width; ++x) {
+                auto height = tree(x, y);
+                auto last = std::next(columnLast.begin(), x * treeHeights);
 
-            if (getTree({x, yPrime}) >= tree) {
-                break;
+                upDistances[index(x, y)] = y - last[height];
+                std::fill(last, std::next(last, height + 1), y);
             }
         }
 
-        // Down
-        auto downScore = 0;
+        // Sweep up the columns for the distance looking down, combining it
+        // with both row sweeps.
+        std::fill(columnLast.begin(), columnLast.end(), _height - 1);
+        std::vector<ViewDistance> leftDistances(_width);
+
+        for (Distance y = _height - 1; y >= 0; --y) {
+            std::array<Distance, treeHeights> rowLast;
 
-        for (Distance yPrime = y + 1; yPrime < _height; ++yPrime) {
-            ++downScore;
+            rowLast.fill(0);
+            for (Distance x = 0; x < _width; ++x) {
+                auto height = tree(x, y);
 
-            if (getTree({x, yPrime}) >= tree) {
-                break;
+                leftDistances[x] = x - rowLast[height];
+                std::fill(rowLast.begin(), std::next(rowLast.begin(), height + 1), x);
             }
-        }
 
-        // Left
-        auto leftScore = 0;
+            rowLast.fill(_width - 1);
+            for (Distance x = _width - 1; x >= 0; --x) {
+                auto height = tree(x, y);
+                auto last = std::next(columnLast.begin(), x * treeHeights);
 
-        for (Distance xPrime = x - 1; xPrime >= 0; --xPrime) {
-            ++leftScore;
+                Score right = rowLast[height] - x;
+                Score down = last[height] - y;
+                std::fill(rowLast.begin(), std::next(rowLast.begin(), height + 1), x);
+                std::fill(last, std::next(last, height + 1), y);
 
-            if (getTree({xPrime, y}) >= tree) {
-                break;
+                visit(x, y, upDistances[index(x, y)] * down * leftDistances[x] * right);
             }
         }
+    }
 
-        // Right
-        auto rightScore = 0;
+    Score highestSenicScore()
+        const
+    {
+        Score highest = 0;
 
-        for (Distance xPrime = x + 1; xPrime < _width; ++xPrime) {
-            ++rightScore;
+        forEachScenicScore([&highest](Distance, Distance, Score score) {
+            highest = std::max(highest, score);
+        });
 
-            if (getTree({xPrime, y}) >= tree) {
-                break;
-            }
+        return highest;
+    }
+
+    // Stores the product of the viewing distances towards both ends of a
+    // line of trees.
+    static void viewLine(const Tree * line, Distance length, std::uint32_t * products)
+    {
+        std::array<Distance, treeHeights> last;
+
+        last.fill(0);
+        for (Distance i = 0; i < length; ++i) {
+            products[i] = i - last[line[i]];
+            std::fill(last.begin(), std::next(last.begin(), line[i] + 1), i);
         }
 
-        return upScore
-            * downScore
-            * leftScore
-            * rightScore;
+        last.fill(length - 1);
+        for (Distance i = length - 1; i >= 0; --i) {
+            products[i] *= last[line[i]] - i;
+            std::fill(last.begin(), std::next(last.begin(), line[i] + 1), i);
+        }
     }
 
-    Distance highestSenicScore()
+    // Runs the row sweeps and the column sweeps (over a transposed copy) on
+    // separate blocks per thread, then merges both results tile by tile.
+    Score highestSenicScoreParallel(unsigned threadCount)
+        const
     {
-        Distance highest = 0;
+        checkViewDistances();
 
-        for (Distance y = 0; y < _height; ++y) {
-            for (Distance x = 0; x < _width; ++x) {
-                auto score = scenicScore({x, y});
+        auto columns{transposed(threadCount)};
+        std::vector<std::uint32_t> rowProducts(_trees.size());
+        std::vector<std::uint32_t> columnProducts(_trees.size());
 
-                if (score > highest) {
-                    highest = score;
-                }
+        parallelFor(_height, threadCount, [&](unsigned, Distance begin, Distance end) {
+            for (Distance y = begin; y < end; ++y) {
+                viewLine(&_trees[index(0, y)], _width, &rowProducts[index(0, y)]);
             }
-        }
+        });
 
-        return highest;
+        parallelFor(_width, threadCount, [&](unsigned, Distance begin, Distance end) {
+            for (Distance x = begin; x < end; ++x) {
+                auto offset = static_cast<std::size_t>(x) * _height;
+                viewLine(&columns[offset], _height, &columnProducts[offset]);
+            }
+        });
+
+        std::vector<Score> highest(threadCount, 0);
+
+        forEachTiled(threadCount, [&](unsigned chunk, Distance x, Distance y) {
+            Score score = Score{rowProducts[index(x, y)]}
+                * columnProducts[static_cast<std::size_t>(x) * _height + y];
+            highest[chunk] = std::max(highest[chunk], score);
+        });
+
+        return *std::max_element(highest.begin(), highest.end());
     }
 
 #ifdef DEBUG
@@ -151,11 +306,16 @@ public:
         std::ios::fmtflags oldFmtFlags = std::cout.flags();
 
         auto printWidth = std::to_string(std::pow(std::max(_height - 1, _width - 1), 4)).length();
+        std::vector<Score> scores(_trees.size());
+
+        forEachScenicScore([&](Distance x, Distance y, Score score) {
+            scores[index(x, y)] = score;
+        });
 
         for (Distance y = 0; y < _height; ++y) {
             for (Distance x = 0; x < _width; ++x) {
                 std::cout << "["
-                          << std::setfill('0') << std::setw(printWidth) << scenicScore({x, y})
+                          << std::setfill('0') << std::setw(printWidth) << scores[index(x, y)]
                           << std::resetiosflags(oldFmtFlags)
                           << "]";
             }
@@ -167,14 +327,85 @@ public:
 #endif
 };
 
-int main()
+// Writes a random square forest in the puzzle's input format.
+std::string generateForest(Distance size)
 {
+    std::mt19937 rng{8};
+    std::uniform_int_distribution<int> heightDist{0, treeHeights - 1};
+    std::string forest;
+    forest.reserve(static_cast<std::size_t>(size + 1) * size);
+
+    for (Distance y = 0; y < size; ++y) {
+        for (Distance x = 0; x < size; ++x) {
+            forest += static_cast<char>('0' + heightDist(rng));
+        }
+        forest += '\n';
+    }
+
+    return forest;
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned threadCount = 0;
+    Distance benchmarkSize = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+
+        if ((arg == "--threads") && (i + 1 < argc)) {
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if ((arg == "--bench") && (i + 1 < argc)) {
+            benchmarkSize = std::stoi(argv[++i]);
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [--threads N] [--bench SIZE]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Times a generated forest sequentially and with 1, 2, 4... threads.
+    if (benchmarkSize > 0) {
+        std::istringstream iss{generateForest(benchmarkSize)};
+        Forest forest(iss);
+        unsigned maxThreads = (threadCount > 0)
+            ? threadCount
+            : std::max(1u, std::thread::hardware_concurrency());
+
+        auto report = [](const std::string & name, auto start, auto result) {
+            std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+            std::cout << std::setw(12) << std::left << name
+                      << std::setw(12) << result
+                      << std::fixed << std::setprecision(1) << elapsed.count() << " ms" << std::endl;
+        };
+
+        std::cout << benchmarkSize << "x" << benchmarkSize << " forest" << std::endl;
+
+        auto start{std::chrono::steady_clock::now()};
+        auto result{forest.highestSenicScore()};
+        report("sequential", start, result);
+
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            start = std::chrono::steady_clock::now();
+            result = forest.highestSenicScoreParallel(threads);
+            report(std::to_string(threads) + " threads", start, result);
+        }
+
+        return 0;
+    }
+
     Forest forest(std::cin);
 
 #ifdef DEBUG
     forest.printScenicMap();
 #endif
 
+    if (threadCount > 0) {
+        std::cout << forest.highestSenicScoreParallel(threadCount) << std::endl;
+        return 0;
+    }
+
     std::cout << forest.highestSenicScore() << std::endl;
 
     return 0;
@@ -1,7 +1,9 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <iterator>
 #include <iostream>
 #include <limits>
-#include <map>
-#include <set>
 #include <sstream>
 #include <utility>
 #include <vector>
@@ -32,138 +34,200 @@ std::ostream & operator<<(std::ostream & os, const Direction & direction)
 
 using Distance = long long;
 using Motion = std::pair<Direction, Distance>;
-using CoordinatePair = std::pair<Distance, Distance>;
+using Coordinate = std::int32_t;
 
-class Position
+// Set of visited cells stored as a bitmap that grows to cover every
+// inserted coordinate.
+class VisitedGrid
 {
 private:
-    Distance _x, _y;
+    static constexpr Distance wordBits = 64;
 
-public:
-    Position()
-        : _x(0)
-        , _y(0)
-    {}
-
-    ~Position() = default;
+    Distance _minX, _minY;
+    Distance _width, _height;
+    std::vector<std::uint64_t> _words;
+    std::size_t _count;
 
-    auto x() const { return _x; }
-    auto y() const { return _y; }
-
-    bool operator==(const Position & other)
+    bool inBounds(Distance x, Distance y)
         const
     {
-        return ((_x == other._x) && (_y == other._y));
+        return ((x >= _minX) && (x < _minX + _width) &&
+                (y >= _minY) && (y < _minY + _height));
     }
 
-    CoordinatePair getCoordinatePair()
+    std::pair<std::size_t, std::uint64_t> locate(Distance x, Distance y)
         const
     {
-        return std::make_pair(_x, _y);
+        auto column = x - _minX;
+        auto word = (y - _minY) * (_width / wordBits) + column / wordBits;
+        return {static_cast<std::size_t>(word), std::uint64_t{1} << (column % wordBits)};
     }
 
-    bool touching(const Position & other)
-        const
+    // Doubles the grid towards the coordinate until it fits.
+    void grow(Distance x, Distance y)
     {
-        if ((_x == other._x - 1) ||
-            (_x == other._x    ) ||
-            (_x == other._x + 1)) {
-            if ((_y == other._y - 1) ||
-                (_y == other._y    ) ||
-                (_y == other._y + 1)) {
-                return true;
+        VisitedGrid grown{*this};
+
+        while (!grown.inBounds(x, y)) {
+            if (x < grown._minX) {
+                grown._minX -= grown._width;
+                grown._width *= 2;
             }
+            else if (x >= grown._minX + grown._width) {
+                grown._width *= 2;
+            }
+
+            if (y < grown._minY) {
+                grown._minY -= grown._height;
+                grown._height *= 2;
+            }
+            else if (y >= grown._minY + grown._height) {
+                grown._height *= 2;
+            }
+        }
+
+        grown._words.assign(grown._width / wordBits * grown._height, 0);
+
+        // Widths are whole words, so each old row copies across intact.
+        auto rowWords = _width / wordBits;
+
+        for (auto cy = _minY; cy < _minY + _height; ++cy) {
+            auto source = std::next(_words.begin(), locate(_minX, cy).first);
+            auto target = std::next(grown._words.begin(), grown.locate(_minX, cy).first);
+            std::copy(source, std::next(source, rowWords), target);
+        }
+
+        *this = std::move(grown);
+    }
+
+public:
+    VisitedGrid()
+        : _minX(-wordBits / 2)
+        , _minY(-wordBits / 2)
+        , _width(wordBits)
+        , _height(wordBits)
+        , _words(wordBits, 0)
+        , _count(0)
+    {}
+
+    ~VisitedGrid() = default;
+
+    auto count() const { return _count; }
+    auto minX() const { return _minX; }
+    auto minY() const { return _minY; }
+    auto maxX() const { return _minX + _width - 1; }
+    auto maxY() const { return _minY + _height - 1; }
+
+    bool contains(Distance x, Distance y)
+        const
+    {
+        if (!inBounds(x, y)) {
+            return false;
         }
 
-        return false;
+        auto [word, mask] = locate(x, y);
+        return (_words[word] & mask) != 0;
     }
 
-    bool sameRowOrCol(const Position & other)
+    void insert(Distance x, Distance y)
     {
-        return ((_x == other._x) || (_y == other._y));
+        if (!inBounds(x, y)) {
+            grow(x, y);
+        }
+
+        auto [word, mask] = locate(x, y);
+
+        if ((_words[word] & mask) == 0) {
+            _words[word] |= mask;
+            ++_count;
+        }
     }
+};
+
+class Rope
+{
+private:
+    // Knot coordinates kept in separate arrays, head first.
+    std::vector<Coordinate> _xs;
+    std::vector<Coordinate> _ys;
+    std::vector<int> _trackedKnots;
+    std::vector<VisitedGrid> _visited;
+
+    int size() const { return static_cast<int>(_xs.size()); }
 
-    void applyDirection(const Direction & direction)
+    void moveHead(const Direction & direction)
     {
         switch(direction) {
         case Direction::up:
-            ++_y;
+            ++_ys.front();
             break;
         case Direction::down:
-            --_y;
+            --_ys.front();
             break;
         case Direction::left:
-            --_x;
+            --_xs.front();
             break;
         case Direction::right:
-            ++_x;
+            ++_xs.front();
             break;
         }
     }
 
-    void reconnect(const Position & other)
+    // Steps a knot one cell towards the knot ahead of it unless they are
+    // touching, returning whether it moved.
+    bool follow(int knot)
     {
-        for (const auto & direction : {
-                Direction:: up,
-                Direction::down,
-                Direction::left,
-                Direction::right,
-            }) {
-            Position candidate = *this;
-            candidate.applyDirection(direction);
-
-            if (candidate.touching(other)) {
-                applyDirection(direction);
-                return;
-            }
+        Coordinate dx = _xs[knot - 1] - _xs[knot];
+        Coordinate dy = _ys[knot - 1] - _ys[knot];
+
+        if ((std::abs(dx) <= 1) && (std::abs(dy) <= 1)) {
+            return false;
         }
 
-        std::cerr << "unable to reconnect" << std::endl;
-        std::terminate();
+        _xs[knot] += (dx > 0) - (dx < 0);
+        _ys[knot] += (dy > 0) - (dy < 0);
+
+        return true;
     }
 
-    void reconnectDiag(const Position & other)
+    // Records every tracked knot up to and including lastMoved.
+    void recordKnots(int lastMoved)
     {
-        for (const auto & directionA : { Direction::up, Direction::down }) {
-            for (const auto & directionB : { Direction::left, Direction::right}) {
-                Position candidate = *this;
-                candidate.applyDirection(directionA);
-                candidate.applyDirection(directionB);
-
-                if (candidate.touching(other)) {
-                    applyDirection(directionA);
-                    applyDirection(directionB);
-                    return;
-                }
-            }
+        for (std::size_t i = 0;
+             (i < _trackedKnots.size()) && (_trackedKnots[i] <= lastMoved);
+             ++i) {
+            auto knot = _trackedKnots[i];
+            _visited[i].insert(_xs[knot], _ys[knot]);
         }
-
-        std::cerr << "unable to reconnect diagonally" << std::endl;
-        std::terminate();
     }
-};
 
-class Rope
-{
-private:
-    std::vector<Position> _knots;
-    std::map<CoordinatePair, Distance> _tailPositions;
 public:
-    explicit Rope(int size)
-        : _knots(size)
+    // Records the positions visited by each tracked knot, so one rope
+    // answers for every shorter rope as well.
+    Rope(int size, std::vector<int> trackedKnots)
+        : _xs(size, 0)
+        , _ys(size, 0)
+        , _trackedKnots(std::move(trackedKnots))
     {
-        recordTail();
-    }
+        std::sort(_trackedKnots.begin(), _trackedKnots.end());
+        _trackedKnots.erase(std::unique(_trackedKnots.begin(), _trackedKnots.end()),
+                            _trackedKnots.end());
+
+        if (!_trackedKnots.empty() &&
+            ((_trackedKnots.front() < 0) || (_trackedKnots.back() >= size))) {
+            std::cerr << "tracked knot outside rope of size " << size << std::endl;
+            std::terminate();
+        }
 
-    ~Rope() = default;
+        _visited.resize(_trackedKnots.size());
+        recordKnots(size - 1);
+    }
 
-    Position & head() { return _knots.front(); }
-    Position & tail() { return _knots.back();  }
+    explicit Rope(int size)
+        : Rope(size, {size - 1})
+    {}
 
-    void recordTail()
-    {
-        ++_tailPositions[tail().getCoordinatePair()];
-    }
+    ~Rope() = default;
 
     void applyMotion(Motion motion)
     {
@@ -171,37 +235,30 @@ public:
         auto steps = motion.second;
 
         for (decltype(steps) i = 0; i < steps; ++i) {
-            head().applyDirection(direction);
+            moveHead(direction);
 
-            for (auto curr = std::next(_knots.begin());
-                 curr != _knots.end();
-                 ++curr) {
-                auto prev = std::prev(curr);
+            // Once a knot stays put, every knot behind it does too.
+            int knot = 1;
 
-                if (!curr->touching(*prev)) {
-                    if (curr->sameRowOrCol(*prev)) {
-                        curr->reconnect(*prev);
-                    }
-                    else {
-                        curr->reconnectDiag(*prev);
-                    }
-                }
+            while ((knot < size()) && follow(knot)) {
+                ++knot;
             }
 
-            recordTail();
+            recordKnots(knot - 1);
         }
     }
 
-    std::set<CoordinatePair> tailPositions()
+    std::size_t visitedCount(int knot)
         const
     {
-        std::set<CoordinatePair> keys;
+        auto iter = std::lower_bound(_trackedKnots.begin(), _trackedKnots.end(), knot);
 
-        for (const auto & [key, _] : _tailPositions) {
-            keys.insert(key);
+        if ((iter == _trackedKnots.end()) || (*iter != knot)) {
+            std::cerr << "knot " << knot << " is not tracked" << std::endl;
+            std::terminate();
         }
 
-        return keys;
+        return _visited[std::distance(_trackedKnots.begin(), iter)].count();
     }
 
 #ifdef DEBUG
@@ -214,9 +271,9 @@ public:
         Distance lowestX = std::numeric_limits<Distance>::max();
         Distance lowestY = std::numeric_limits<Distance>::max();
 
-        for (const auto & position : _knots) {
-            auto x = position.x();
-            auto y = position.y();
+        for (int i = 0; i < size(); ++i) {
+            Distance x = _xs[i];
+            Distance y = _ys[i];
 
             if (x > highestX) {
                 highestX = x;
@@ -235,25 +292,15 @@ public:
             }
         }
 
-        for (const auto & [coordPair, distance] : _tailPositions) {
-            auto x = coordPair.first;
-            auto y = coordPair.second;
-
-            if (x > highestX) {
-                highestX = x;
-            }
-
-            if (x < lowestX) {
-                lowestX = x;
-            }
-
-            if (y > highestY) {
-                highestY = y;
-            }
+        // Show the path of the last tracked knot.
+        const VisitedGrid emptyGrid;
+        const auto & tailPositions = _visited.empty() ? emptyGrid : _visited.back();
 
-            if (y < lowestY) {
-                lowestY = y;
-            }
+        if (tailPositions.count() > 0) {
+            highestX = std::max(highestX, tailPositions.maxX());
+            highestY = std::max(highestY, tailPositions.maxY());
+            lowestX = std::min(lowestX, tailPositions.minX());
+            lowestY = std::min(lowestY, tailPositions.minY());
         }
 
         // Print display.
@@ -262,10 +309,8 @@ public:
                 // Display index on rope
                 bool knotFound = false;
 
-                for (decltype(_knots)::size_type i = 0; i < _knots.size(); ++i) {
-                    auto knot = _knots[i];
-
-                    if ((knot.x() == x) && (knot.y() == y)) {
+                for (int i = 0; i < size(); ++i) {
+                    if ((_xs[i] == x) && (_ys[i] == y)) {
                         if (i == 0) {
                             std::cout << 'H';
                         }
@@ -289,17 +334,8 @@ public:
                 }
                 
                 // Display previous tail positions.
-                bool tailFound = false;
-
-                for (const auto & [coordPair, _] : _tailPositions) {
-                    if ((coordPair.first == x) && (coordPair.second == y)) {
-                        tailFound = true;
-                        std::cout << '#';
-                        break;
-                    }
-                }
-
-                if (tailFound) {
+                if (tailPositions.contains(x, y)) {
+                    std::cout << '#';
                     continue;
                 }
 
@@ -352,9 +388,31 @@ std::vector<Motion> parseInput(std::istream & is)
     return motions;
 }
 
-int main()
+int main(int argc, char * argv[])
 {
-    Rope rope{10};
+    // Arguments are knot counts to simulate together with one rope.
+    std::vector<int> knotCounts;
+
+    for (int i = 1; i < argc; ++i) {
+        knotCounts.push_back(std::stoi(argv[i]));
+
+        if (knotCounts.back() < 1) {
+            std::cerr << "rope needs at least one knot" << std::endl;
+            return 1;
+        }
+    }
+
+    if (knotCounts.empty()) {
+        knotCounts.push_back(10);
+    }
+
+    std::vector<int> tails;
+    std::transform(knotCounts.begin(),
+                   knotCounts.end(),
+                   std::back_inserter(tails),
+                   [](int knots) { return knots - 1; });
+
+    Rope rope{*std::max_element(knotCounts.begin(), knotCounts.end()), tails};
     auto motions{parseInput(std::cin)};
 
     std::for_each(
@@ -366,7 +424,14 @@ int main()
     rope.printRope();
 #endif
 
-    std::cout << rope.tailPositions().size() << std::endl;
+    if (knotCounts.size() == 1) {
+        std::cout << rope.visitedCount(tails.front()) << std::endl;
+        return 0;
+    }
+
+    for (const auto & knots : knotCounts) {
+        std::cout << knots << ": " << rope.visitedCount(knots - 1) << std::endl;
+    }
 
     return 0;
 }
@@ -1,12 +1,20 @@
-#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <numeric>
+#include <optional>
+#include <random>
 #include <sstream>
+#include <string>
+#include <string_view>
 #include <vector>
 
 enum class InstructionType { noop, addx };
 
-InstructionType instructionTypeFromString(const std::string & s) {
+InstructionType instructionTypeFromString(std::string_view s) {
     if (s == "noop") {
         return InstructionType::noop;
     }
@@ -19,62 +27,180 @@ InstructionType instructionTypeFromString(const std::string & s) {
     std::terminate();
 }
 
-constexpr auto cyclesToEvaluate = std::to_array({20, 60, 100, 140, 180, 220});
-int total = 0;
+using Register = std::int64_t;
 
-void evaluateSignalStrength(const int & cycle, const int & registerX)
+// A program compiled to the change of register X at the end of each cycle.
+// Cycle c (1-based) is entry c - 1; noop contributes one zero, addx a zero
+// and then its value.
+class CompiledProgram
 {
-    if (std::any_of(
-            cyclesToEvaluate.begin(),
-            cyclesToEvaluate.end(),
-            [&cycle](auto cycleIndex){ return cycle == cycleIndex; })) {
+private:
+    std::vector<Register> _deltas;
+
+public:
+    explicit CompiledProgram(std::istream & is)
+    {
+        for (std::string line; std::getline(is, line);) {
+            std::string_view text{line};
+
+            if (!text.empty() && (text.back() == '\r')) {
+                text.remove_suffix(1);
+            }
+
+            auto space = text.find(' ');
+            auto instrType = instructionTypeFromString(text.substr(0, space));
+
+            switch (instrType) {
+            case InstructionType::noop: {
+                _deltas.push_back(0);
+                break;
+            }
+            case InstructionType::addx: {
+                auto valueStr = (space == std::string_view::npos) ? std::string_view{} : text.substr(space + 1);
+                Register value = 0;
+                auto [end, ec] = std::from_chars(valueStr.data(), valueStr.data() + valueStr.size(), value);
+
+                if ((ec != std::errc()) || (end != valueStr.data() + valueStr.size())) {
+                    std::cerr << "unable to parse addx value: " << line << std::endl;
+                    std::terminate();
+                }
+
+                _deltas.push_back(0);
+                _deltas.push_back(value);
+                break;
+            }
+            }
+        }
+    }
+
+    ~CompiledProgram() = default;
+
+    auto cycles() const { return _deltas.size(); }
+
+    // Value of register X during every cycle: a prefix sum of the deltas
+    // starting from 1.
+    std::vector<Register> registerTrace() const
+    {
+        std::vector<Register> trace(_deltas.size());
+        std::exclusive_scan(_deltas.begin(), _deltas.end(), trace.begin(), Register{1});
+        return trace;
+    }
+};
+
+// Writes a random program of instructionCount instructions.
+std::string generateProgram(std::size_t instructionCount)
+{
+    std::mt19937 rng{10};
+    std::uniform_int_distribution<int> valueDist{-20, 20};
+    std::bernoulli_distribution addxDist{0.6};
+    std::string program;
+
+    for (std::size_t i = 0; i < instructionCount; ++i) {
+        if (addxDist(rng)) {
+            program += "addx " + std::to_string(valueDist(rng)) + "\n";
+        }
+        else {
+            program += "noop\n";
+        }
+    }
+
+    return program;
+}
+
+// Parses a whole command line argument as a count.
+std::optional<std::size_t> parseCount(std::string_view text)
+{
+    std::size_t value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+    if ((ec != std::errc()) || text.empty() || (end != text.data() + text.size())) {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+// Signal strength is sampled at cycle 20 and every 40 cycles after it.
+constexpr std::size_t firstSampledCycle = 20;
+constexpr std::size_t samplingInterval = 40;
+constexpr std::size_t lastSampledCycle = 220;
+
+Register sumSignalStrengths(const std::vector<Register> & trace, std::size_t lastCycle)
+{
+    Register total = 0;
+
+    for (auto cycle = firstSampledCycle; (cycle <= lastCycle) && (cycle <= trace.size()); cycle += samplingInterval) {
+        auto registerX = trace[cycle - 1];
+
 #ifdef DEBUG
         std::cout
             << "cycle(" << cycle << ") = {" << std::endl
             << "  registerX     = " << registerX << std::endl
-            << "  signalStrenth = " << (cycle * registerX) << std::endl
+            << "  signalStrenth = " << (static_cast<Register>(cycle) * registerX) << std::endl
             << "};" << std::endl;
 #endif
-        total += cycle * registerX;
+
+        total += static_cast<Register>(cycle) * registerX;
     }
+
+    return total;
 }
 
-void executeProgram(std::istream & is)
+void benchmark(std::size_t instructionCount)
 {
-    int cycle = 1;
-    int registerX = 1;
+    std::istringstream iss{generateProgram(instructionCount)};
 
-    for(std::string line; std::getline(is, line);) {
-        std::stringstream ss{line};
-        std::string instrTypeStr, valueStr;
-        ss >> instrTypeStr >> valueStr;
+    auto start{std::chrono::steady_clock::now()};
+    CompiledProgram program(iss);
+    auto compiled{std::chrono::steady_clock::now()};
+    auto trace{program.registerTrace()};
+    auto total{sumSignalStrengths(trace, trace.size())};
+    auto summed{std::chrono::steady_clock::now()};
 
-        auto instrType = instructionTypeFromString(instrTypeStr);
-        auto value = valueStr.length() > 0 ? std::stoi(valueStr) : 0;
+    std::chrono::duration<double, std::milli> compileTime{compiled - start};
+    std::chrono::duration<double, std::milli> sumTime{summed - compiled};
 
-        evaluateSignalStrength(cycle , registerX);
+    std::cout
+        << instructionCount << " instructions, " << program.cycles() << " cycles" << std::endl
+        << std::fixed << std::setprecision(1)
+        << "compile: " << compileTime.count() << " ms" << std::endl
+        << "trace and sum: " << sumTime.count() << " ms (" << total << ")" << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+    auto lastCycle = lastSampledCycle;
+    std::optional<std::size_t> benchmarkInstructions;
 
-        switch (instrType) {
-        case InstructionType::noop: {
-            ++cycle;
-            break;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+        bool valid = true;
+
+        if ((arg == "--bench") && (i + 1 < argc)) {
+            benchmarkInstructions = parseCount(argv[++i]);
+            valid = benchmarkInstructions.has_value();
+        }
+        else if (arg == "--all") {
+            lastCycle = std::numeric_limits<std::size_t>::max();
         }
-        case InstructionType::addx: {
-            ++cycle;
-            evaluateSignalStrength(cycle , registerX);
-            ++cycle;
-            registerX += value;
-            break;
+        else {
+            valid = false;
         }
+
+        if (!valid) {
+            std::cerr << "usage: " << argv[0] << " [--all] [--bench INSTRUCTIONS]" << std::endl;
+            return 1;
         }
     }
-}
 
-int main()
-{
-    executeProgram(std::cin);
+    if (benchmarkInstructions) {
+        benchmark(*benchmarkInstructions);
+        return 0;
+    }
+
+    CompiledProgram program(std::cin);
 
-    std::cout << total << std::endl;
+    std::cout << sumSignalStrengths(program.registerTrace(), lastCycle) << std::endl;
         
     return 0;
 }
@@ -1,12 +1,21 @@
+#include <algorithm>
 #include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
 #include <numeric>
+#include <optional>
+#include <random>
 #include <sstream>
-#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
 
 enum class InstructionType { noop, addx };
 
-InstructionType instructionTypeFromString(const std::string & s) {
+InstructionType instructionTypeFromString(std::string_view s) {
     if (s == "noop") {
         return InstructionType::noop;
     }
@@ -19,101 +28,209 @@ InstructionType instructionTypeFromString(const std::string & s) {
     std::terminate();
 }
 
+using Register = std::int64_t;
 
-constexpr int crtWidth = 40;
-constexpr int crtHeight = 6;
+// A program compiled to the change of register X at the end of each cycle.
+// Cycle c (1-based) is entry c - 1; noop contributes one zero, addx a zero
+// and then its value.
+class CompiledProgram
+{
+private:
+    std::vector<Register> _deltas;
+
+public:
+    explicit CompiledProgram(std::istream & is)
+    {
+        for (std::string line; std::getline(is, line);) {
+            std::string_view text{line};
+
+            if (!text.empty() && (text.back() == '\r')) {
+                text.remove_suffix(1);
+            }
+
+            auto space = text.find(' ');
+            auto instrType = instructionTypeFromString(text.substr(0, space));
+
+            switch (instrType) {
+            case InstructionType::noop: {
+                _deltas.push_back(0);
+                break;
+            }
+            case InstructionType::addx: {
+                auto valueStr = (space == std::string_view::npos) ? std::string_view{} : text.substr(space + 1);
+                Register value = 0;
+                auto [end, ec] = std::from_chars(valueStr.data(), valueStr.data() + valueStr.size(), value);
+
+                if ((ec != std::errc()) || (end != valueStr.data() + valueStr.size())) {
+                    std::cerr << "unable to parse addx value: " << line << std::endl;
+                    std::terminate();
+                }
+
+                _deltas.push_back(0);
+                _deltas.push_back(value);
+                break;
+            }
+            }
+        }
+    }
+
+    ~CompiledProgram() = default;
 
-std::array<std::array<char, crtWidth>, crtHeight> display;
+    auto cycles() const { return _deltas.size(); }
 
-constexpr std::array<std::pair<std::pair<int, int>, int>, crtHeight> cycleToDisplayRow{{
-    {{  1,  40}, 0},
-    {{ 41,  80}, 1},
-    {{ 81, 120}, 2},
-    {{121, 160}, 3},
-    {{161, 200}, 4},
-    {{201, 240}, 5},
-}};
+    // Value of register X during every cycle: a prefix sum of the deltas
+    // starting from 1.
+    std::vector<Register> registerTrace() const
+    {
+        std::vector<Register> trace(_deltas.size());
+        std::exclusive_scan(_deltas.begin(), _deltas.end(), trace.begin(), Register{1});
+        return trace;
+    }
+};
 
-int getCycleToDisplayRow(const int & cycle)
+// Writes a random program of instructionCount instructions.
+std::string generateProgram(std::size_t instructionCount)
 {
-    for (const auto & [range, row] : cycleToDisplayRow) {
-        if ((cycle >= range.first) && (cycle <= range.second)) {
-            return row;
+    std::mt19937 rng{10};
+    std::uniform_int_distribution<int> valueDist{-20, 20};
+    std::bernoulli_distribution addxDist{0.6};
+    std::string program;
+
+    for (std::size_t i = 0; i < instructionCount; ++i) {
+        if (addxDist(rng)) {
+            program += "addx " + std::to_string(valueDist(rng)) + "\n";
+        }
+        else {
+            program += "noop\n";
         }
-    } 
+    }
 
-    std::cerr << "unable to determine row for cycle: " << cycle << std::endl;
-    std::terminate();
+    return program;
 }
 
-int getCycleToDisplayCol(const int & cycle)
+// Parses a whole command line argument as a count.
+std::optional<std::size_t> parseCount(std::string_view text)
 {
-    return (cycle % crtWidth) - 1;
-}
-    
-void drawPixel(const int & cycle, const int & registerX)
-{
-    auto x = getCycleToDisplayCol(cycle);
+    std::size_t value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
 
-    if ((x >= registerX - 1) && (x <= registerX + 1)) {
-        auto y = getCycleToDisplayRow(cycle);
-        display[y][x] = '#';
+    if ((ec != std::errc()) || text.empty() || (end != text.data() + text.size())) {
+        return std::nullopt;
     }
+
+    return value;
 }
 
-void executeProgram(std::istream & is)
+constexpr std::size_t defaultCrtWidth = 40;
+constexpr std::size_t defaultCrtHeight = 6;
+
+// Draws one pixel per cycle, row by row, lit where the three pixel sprite
+// centred on register X covers the column being drawn. Pixels the program
+// never reaches stay dark; cycles past the last row are not drawn. Rows
+// below the last one the program reaches are left out. Pixels go out through
+// a fixed buffer, so any display size needs constant memory. Returns the
+// number of lit pixels.
+std::size_t renderDisplay(std::ostream & os, const std::vector<Register> & trace, std::size_t width, std::size_t height)
 {
-    int cycle = 1;
-    int registerX = 1;
+    height = std::min(height, (trace.size() + width - 1) / width);
 
-    for(std::string line; std::getline(is, line);) {
-        std::stringstream ss{line};
-        std::string instrTypeStr, valueStr;
-        ss >> instrTypeStr >> valueStr;
+    std::array<char, 1 << 16> buffer;
+    std::size_t used = 0;
+    std::size_t litCount = 0;
 
-        auto instrType = instructionTypeFromString(instrTypeStr);
-        auto value = valueStr.length() > 0 ? std::stoi(valueStr) : 0;
+    auto put = [&](char c) {
+        if (used == buffer.size()) {
+            os.write(buffer.data(), used);
+            used = 0;
+        }
 
-        drawPixel(cycle, registerX);
+        buffer[used++] = c;
+    };
 
-        switch (instrType) {
-        case InstructionType::noop: {
-            ++cycle;
-            break;
-        }
-        case InstructionType::addx: {
-            ++cycle;
-            drawPixel(cycle, registerX);
-            ++cycle;
-            registerX += value;
-            break;
-        }
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+            auto cycle = y * width + x;
+            auto lit = (cycle < trace.size()) &&
+                (trace[cycle] >= static_cast<Register>(x) - 1) &&
+                (trace[cycle] <= static_cast<Register>(x) + 1);
+
+            litCount += lit;
+            put(lit ? '#' : '.');
         }
+
+        put('\n');
     }
+
+    os.write(buffer.data(), used);
+    return litCount;
 }
 
-void printDisplay()
+void benchmark(std::size_t instructionCount, std::size_t width)
 {
-    for (int y = 0; y < crtHeight; ++y) {
-        for (int x = 0; x < crtWidth; ++x) {
-            std::cout << display[y][x];
-        }
-        std::cout << std::endl;
-    }
+    std::istringstream iss{generateProgram(instructionCount)};
+
+    auto start{std::chrono::steady_clock::now()};
+    CompiledProgram program(iss);
+    auto compiled{std::chrono::steady_clock::now()};
+    auto trace{program.registerTrace()};
+    std::ostringstream display;
+    auto litCount{renderDisplay(display, trace, width, (trace.size() + width - 1) / width)};
+    auto rendered{std::chrono::steady_clock::now()};
+
+    std::chrono::duration<double, std::milli> compileTime{compiled - start};
+    std::chrono::duration<double, std::milli> renderTime{rendered - compiled};
+
+    std::cout
+        << instructionCount << " instructions, " << program.cycles() << " cycles" << std::endl
+        << std::fixed << std::setprecision(1)
+        << "compile: " << compileTime.count() << " ms" << std::endl
+        << "trace and render: " << renderTime.count() << " ms ("
+        << litCount << " lit)" << std::endl;
 }
 
-int main()
+int main(int argc, char * argv[])
 {
-    // Initialize display.
-    for (int y = 0; y < crtHeight; ++y) {
-        for (int x = 0; x < crtWidth; ++x) {
-            display[y][x] = '.';
+    auto width = defaultCrtWidth;
+    auto height = defaultCrtHeight;
+    std::size_t benchmarkInstructions = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+        std::optional<std::size_t> value;
+
+        if (((arg == "--width") || (arg == "--height") || (arg == "--bench")) && (i + 1 < argc)) {
+            value = parseCount(argv[++i]);
+        }
+
+        if (value && (arg == "--width")) {
+            width = *value;
+        }
+        else if (value && (arg == "--height")) {
+            height = *value;
+        }
+        else if (value && (arg == "--bench")) {
+            benchmarkInstructions = *value;
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [--width W] [--height H] [--bench INSTRUCTIONS]" << std::endl;
+            return 1;
         }
     }
 
-    executeProgram(std::cin);
+    if (width == 0) {
+        std::cerr << "display width must be positive" << std::endl;
+        return 1;
+    }
+
+    if (benchmarkInstructions > 0) {
+        benchmark(benchmarkInstructions, width);
+        return 0;
+    }
+
+    CompiledProgram program(std::cin);
 
-    printDisplay();
+    renderDisplay(std::cout, program.registerTrace(), width, height);
+    std::cout << std::flush;
     
     return 0;
 }
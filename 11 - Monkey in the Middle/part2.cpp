@@ -1,14 +1,24 @@
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <functional>
+#include <iomanip>
 #include <iostream>
 #include <numeric>
+#include <optional>
+#include <random>
 #include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <variant>
 #include <vector>
 
 enum class NamedOperationElement { Old };
 
 using Value = std::int64_t;
+__extension__ typedef __int128 WideValue;
+using Size = std::size_t;
 
 using OperationElement = std::variant<NamedOperationElement, Value>;
 
@@ -39,14 +49,14 @@ OperationFunction parseOperationFunction(const std::string & s)
     std::terminate();
 }
 
-std::function<Value(const Value &, const Value &)> getFunction(const OperationFunction & op)
+std::function<WideValue(const WideValue &, const WideValue &)> getFunction(const OperationFunction & op)
 {
     switch (op) {
     case OperationFunction::Addition: {
-        return [](const Value & a, const Value & b){ return a + b; };
+        return [](const WideValue & a, const WideValue & b){ return a + b; };
     }
     case OperationFunction::Multiplication: {
-        return [](const Value & a, const Value & b){ return a * b; };
+        return [](const WideValue & a, const WideValue & b){ return a * b; };
     }
     }
 
@@ -54,6 +64,16 @@ std::function<Value(const Value &, const Value &)> getFunction(const OperationFu
     std::terminate();
 }
 
+enum class OperationTag : std::uint8_t { Add, Multiply, Double, Square };
+
+// Operation reduced to a tag and constant so it can be applied without
+// variant or std::function dispatch.
+struct CompiledOperation
+{
+    OperationTag tag;
+    Value constant;
+};
+
 class Operation
 {
 private:
@@ -76,7 +96,9 @@ public:
 
     ~Operation() = default;
 
-    Value apply(Value old)
+    // Applies the operation to a worry level below modulus, reducing the
+    // 128-bit result back below modulus.
+    Value apply(Value old, Value modulus)
     {
         // Get first argument.
         Value a;
@@ -101,7 +123,27 @@ public:
             b = old;
         }
 
-        return func(a, b);
+        return static_cast<Value>(func(a, b) % modulus);
+    }
+
+    CompiledOperation compile()
+        const
+    {
+        bool aIsOld = !std::holds_alternative<Value>(_a);
+        bool bIsOld = !std::holds_alternative<Value>(_b);
+
+        if (aIsOld && bIsOld) {
+            return {_func == OperationFunction::Addition ? OperationTag::Double : OperationTag::Square, 0};
+        }
+
+        Value constant = aIsOld ? std::get<Value>(_b) : std::get<Value>(_a);
+
+        if (!aIsOld && !bIsOld) {
+            std::cerr << "operation does not use old value" << std::endl;
+            std::terminate();
+        }
+
+        return {_func == OperationFunction::Addition ? OperationTag::Add : OperationTag::Multiply, constant};
     }
 };
 
@@ -117,7 +159,7 @@ private:
     int _divisible;
     int _trueIndex;
     int _falseIndex;
-    int _totalInspections;
+    Value _totalInspections;
 
 public:
     Monkey()
@@ -219,7 +261,11 @@ public:
     ~Monkey() = default;
 
     auto index() const { return _index; }
+    auto items() const { return _items; }
+    auto operation() const { return _operation; }
     auto divisible() const { return _divisible; }
+    auto trueIndex() const { return _trueIndex; }
+    auto falseIndex() const { return _falseIndex; }
     auto totalInspections() const { return _totalInspections; }
 
     void catchItem(Value item)
@@ -234,8 +280,7 @@ public:
             _items.pop_front();
 
             auto worryLevel = item;
-            worryLevel = _operation.apply(worryLevel);
-            worryLevel %= lcm;
+            worryLevel = _operation.apply(worryLevel % lcm, lcm);
 
             if (worryLevel % _divisible == 0) {
                 monkeys[_trueIndex].catchItem(worryLevel);
@@ -280,31 +325,549 @@ MonkeyIndexMap parseMonkeys(std::istream & is)
     return monkeyMap;
 }
 
-Value getLCM(const MonkeyIndexMap & monkeys)
+// Returns an empty optional when the lcm does not fit in a Value.
+std::optional<Value> getLCM(const MonkeyIndexMap & monkeys)
+{
+    Value lcm = 1;
+
+    for (const auto & [monkeyIndex, monkey] : monkeys) {
+        Value divisible = monkey.divisible();
+
+        if (__builtin_mul_overflow(lcm, divisible / std::gcd(lcm, divisible), &lcm)) {
+            return std::nullopt;
+        }
+    }
+
+    return lcm;
+}
+
+using Rounds = std::int64_t;
+
+constexpr Rounds numRounds = 10000;
+
+void playGame(MonkeyIndexMap & monkeys, Rounds rounds = numRounds)
+{
+    auto lcm = getLCM(monkeys);
+
+    if (!lcm.has_value()) {
+        std::cerr << "lcm of divisors does not fit in 64 bits" << std::endl;
+        std::terminate();
+    }
+
+    for (Rounds i = 0; i < rounds; ++i) {
+        for (auto & [monkeyIndex, monkey] : monkeys) {
+            monkey.inspectItems(monkeys, *lcm);
+        }
+    }
+}
+
+// Long games overflow 64 bits when the top two counts are multiplied.
+__extension__ typedef unsigned __int128 Score;
+
+std::string scoreToString(Score score)
 {
+    std::string result;
+
+    do {
+        result.insert(result.begin(), static_cast<char>('0' + score % 10));
+        score /= 10;
+    } while (score > 0);
+
+    return result;
+}
+
+Score scoreInspections(std::vector<Value> scores)
+{
+    std::sort(scores.begin(), scores.end());
+
     return std::accumulate(
+        scores.rbegin(),
+        std::next(scores.rbegin(), 2),
+        Score{1},
+        std::multiplies<Score>());
+}
+
+// Worry kept modulo the lcm of all divisors, with products formed in
+// Product. A Value product is only safe while the lcm and every constant
+// stay below 2^31.
+template<typename Product>
+class ModularArithmetic
+{
+private:
+    Value _modulus;
+    std::vector<Value> _divisors;
+
+public:
+    using Worry = Value;
+
+    ModularArithmetic(Value modulus, const std::vector<Value> & divisors)
+        : _modulus(modulus)
+        , _divisors(divisors)
+    {}
+
+    Worry make(Value item) const { return item % _modulus; }
+
+    void apply(Worry & worry, OperationTag tag, Value constant)
+        const
+    {
+        switch (tag) {
+        case OperationTag::Add: {
+            worry = static_cast<Value>((Product{worry} + constant % _modulus) % _modulus);
+            break;
+        }
+        case OperationTag::Multiply: {
+            worry = static_cast<Value>((Product{worry} * (constant % _modulus)) % _modulus);
+            break;
+        }
+        case OperationTag::Double: {
+            worry = static_cast<Value>((Product{worry} + worry) % _modulus);
+            break;
+        }
+        case OperationTag::Square: {
+            worry = static_cast<Value>((Product{worry} * worry) % _modulus);
+            break;
+        }
+        }
+    }
+
+    bool divisible(const Worry & worry, int monkey) const { return worry % _divisors[monkey] == 0; }
+};
+
+using NarrowArithmetic = ModularArithmetic<Value>;
+using WideArithmetic = ModularArithmetic<WideValue>;
+
+// Worry kept as one residue per monkey's divisor, for troops whose lcm does
+// not fit in 64 bits.
+class ResidueArithmetic
+{
+private:
+    std::vector<Value> _divisors;
+
+public:
+    using Worry = std::vector<Value>;
+
+    explicit ResidueArithmetic(const std::vector<Value> & divisors)
+        : _divisors(divisors)
+    {}
+
+    Worry make(Value item)
+        const
+    {
+        Worry worry(_divisors.size());
+
+        for (Size i = 0; i < _divisors.size(); ++i) {
+            worry[i] = item % _divisors[i];
+        }
+
+        return worry;
+    }
+
+    void apply(Worry & worry, OperationTag tag, Value constant)
+        const
+    {
+        for (Size i = 0; i < _divisors.size(); ++i) {
+            const Value & divisor = _divisors[i];
+            Value & residue = worry[i];
+
+            switch (tag) {
+            case OperationTag::Add: {
+                residue = (residue + constant % divisor) % divisor;
+                break;
+            }
+            case OperationTag::Multiply: {
+                residue = (residue * (constant % divisor)) % divisor;
+                break;
+            }
+            case OperationTag::Double: {
+                residue = (residue + residue) % divisor;
+                break;
+            }
+            case OperationTag::Square: {
+                residue = (residue * residue) % divisor;
+                break;
+            }
+            }
+        }
+    }
+
+    bool divisible(const Worry & worry, int monkey) const { return worry[monkey] == 0; }
+};
+
+enum class WorryRepresentation { Narrow, Wide, Residue };
+
+std::string representationToString(WorryRepresentation representation)
+{
+    switch (representation) {
+    case WorryRepresentation::Narrow: {
+        return "narrow";
+    }
+    case WorryRepresentation::Wide: {
+        return "wide";
+    }
+    case WorryRepresentation::Residue: {
+        return "residue";
+    }
+    }
+
+    std::cerr << "unable to get string for worry representation" << std::endl;
+    std::terminate();
+}
+
+// Picks the cheapest representation that cannot overflow.
+WorryRepresentation selectRepresentation(const MonkeyIndexMap & monkeys)
+{
+    constexpr Value narrowLimit = Value{1} << 31;
+    auto lcm = getLCM(monkeys);
+
+    if (!lcm.has_value()) {
+        return WorryRepresentation::Residue;
+    }
+
+    bool narrowConstants = std::all_of(
         monkeys.begin(),
         monkeys.end(),
-        1,
-        [](Value lcm, const std::pair<int, Monkey> & monkeyPair) {
-            return lcm * monkeyPair.second.divisible();
+        [](const std::pair<int, Monkey> & monkeyPair) {
+            return monkeyPair.second.operation().compile().constant < narrowLimit;
         });
+
+    if ((*lcm < narrowLimit) && narrowConstants) {
+        return WorryRepresentation::Narrow;
+    }
+
+    return WorryRepresentation::Wide;
 }
 
-constexpr int numRounds = 10000;
+// Position of an item at the start of a round.
+template<typename Worry>
+struct ItemState
+{
+    int holder;
+    Worry worry;
+
+    bool operator==(const ItemState &) const = default;
+};
+
+// Monkeys compiled into contiguous arrays. Items never interact, so each one
+// is followed through every round on its own.
+template<typename Arithmetic>
+class Troop
+{
+private:
+    using Item = ItemState<typename Arithmetic::Worry>;
+
+    std::vector<OperationTag> _tags;
+    std::vector<Value> _constants;
+    std::vector<int> _trueTargets;
+    std::vector<int> _falseTargets;
+    std::vector<Item> _items;
+    Arithmetic _arithmetic;
+
+public:
+    Troop(const MonkeyIndexMap & monkeys, const Arithmetic & arithmetic)
+        : _arithmetic(arithmetic)
+    {
+        for (const auto & [monkeyIndex, monkey] : monkeys) {
+            auto compiled{monkey.operation().compile()};
+            _tags.push_back(compiled.tag);
+            _constants.push_back(compiled.constant);
+            _trueTargets.push_back(monkey.trueIndex());
+            _falseTargets.push_back(monkey.falseIndex());
+
+            for (const auto & item : monkey.items()) {
+                _items.push_back({monkeyIndex, _arithmetic.make(item)});
+            }
+        }
+    }
+
+    auto size() const { return _tags.size(); }
+    auto items() const { return _items; }
+
+    // Follows an item through one round. Throws to a later monkey are
+    // inspected again within the same round.
+    Item playRound(Item item, std::vector<Value> & inspections)
+        const
+    {
+        while (true) {
+            int monkey = item.holder;
+            ++inspections[monkey];
+
+            _arithmetic.apply(item.worry, _tags[monkey], _constants[monkey]);
+            item.holder = _arithmetic.divisible(item.worry, monkey)
+                ? _trueTargets[monkey]
+                : _falseTargets[monkey];
+
+            if (item.holder <= monkey) {
+                return item;
+            }
+        }
+    }
+
+    Item playItem(Item item, Rounds rounds, std::vector<Value> & inspections)
+        const
+    {
+        for (Rounds round = 0; round < rounds; ++round) {
+            item = playRound(item, inspections);
+        }
+
+        return item;
+    }
+
+    // Each item's state at the start of a round is drawn from a finite space,
+    // so its trajectory eventually cycles. Find the cycle with Brent's
+    // algorithm and extrapolate the inspections over whole cycles.
+    void playItemSkipping(const Item & start, Rounds rounds, std::vector<Value> & inspections)
+        const
+    {
+        std::vector<Value> scratch(size(), 0);
+
+        // Find the cycle length.
+        Rounds power = 1;
+        Rounds cycleLength = 1;
+        Rounds steps = 1;
+        Item tortoise{start};
+        Item hare{playRound(start, scratch)};
+
+        while (tortoise != hare) {
+            // No cycle before the game ends.
+            if (steps >= rounds) {
+                playItem(start, rounds, inspections);
+                return;
+            }
+
+            if (power == cycleLength) {
+                tortoise = hare;
+                power *= 2;
+                cycleLength = 0;
+            }
+
+            hare = playRound(hare, scratch);
+            ++cycleLength;
+            ++steps;
+        }
+
+        // Find the first round of the cycle.
+        Rounds cycleStart = 0;
+        tortoise = start;
+        hare = playItem(start, cycleLength, scratch);
+
+        while (tortoise != hare) {
+            tortoise = playRound(tortoise, scratch);
+            hare = playRound(hare, scratch);
+            ++cycleStart;
+        }
+
+        if (cycleStart + cycleLength >= rounds) {
+            playItem(start, rounds, inspections);
+            return;
+        }
+
+        // Play up to the cycle, one full cycle, then the leftover rounds.
+        auto item{playItem(start, cycleStart, inspections)};
+        std::vector<Value> cycleInspections(size(), 0);
+        playItem(item, cycleLength, cycleInspections);
 
-void playGame(MonkeyIndexMap & monkeys)
+        Rounds remaining = rounds - cycleStart;
+        Rounds cycles = remaining / cycleLength;
+
+        for (Size monkey = 0; monkey < size(); ++monkey) {
+            inspections[monkey] += cycles * cycleInspections[monkey];
+        }
+
+        playItem(item, remaining % cycleLength, inspections);
+    }
+
+    std::vector<Value> playRounds(Rounds rounds, unsigned threadCount, bool skipCycles = false)
+        const
+    {
+        threadCount = std::max(1u, std::min<unsigned>(threadCount, _items.size()));
+        std::vector<std::vector<Value>> partials(threadCount, std::vector<Value>(size(), 0));
+
+        auto playItems = [&](unsigned thread) {
+            for (Size i = thread; i < _items.size(); i += threadCount) {
+                if (skipCycles) {
+                    playItemSkipping(_items[i], rounds, partials[thread]);
+                }
+                else {
+                    playItem(_items[i], rounds, partials[thread]);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned thread = 1; thread < threadCount; ++thread) {
+            workers.emplace_back(playItems, thread);
+        }
+        playItems(0);
+        for (auto & worker : workers) {
+            worker.join();
+        }
+
+        std::vector<Value> inspections(size(), 0);
+        for (const auto & partial : partials) {
+            std::transform(inspections.begin(),
+                           inspections.end(),
+                           partial.begin(),
+                           inspections.begin(),
+                           std::plus<Value>());
+        }
+
+        return inspections;
+    }
+};
+
+std::vector<Value> playTroop(const MonkeyIndexMap & monkeys,
+                             WorryRepresentation representation,
+                             Rounds rounds,
+                             unsigned threadCount,
+                             bool skipCycles)
 {
+    std::vector<Value> divisors;
+    for (const auto & [monkeyIndex, monkey] : monkeys) {
+        divisors.push_back(monkey.divisible());
+    }
+
     auto lcm = getLCM(monkeys);
 
-    for (int i = 0; i < numRounds; ++i) {
-        for (auto & [monkeyIndex, monkey] : monkeys) {
-            monkey.inspectItems(monkeys, lcm);
+    if ((representation != WorryRepresentation::Residue) && !lcm.has_value()) {
+        std::cerr << "lcm of divisors does not fit in 64 bits, "
+                  << representationToString(representation) << " worry unavailable" << std::endl;
+        std::terminate();
+    }
+
+    switch (representation) {
+    case WorryRepresentation::Narrow: {
+        Troop troop{monkeys, NarrowArithmetic{*lcm, divisors}};
+        return troop.playRounds(rounds, threadCount, skipCycles);
+    }
+    case WorryRepresentation::Wide: {
+        Troop troop{monkeys, WideArithmetic{*lcm, divisors}};
+        return troop.playRounds(rounds, threadCount, skipCycles);
+    }
+    case WorryRepresentation::Residue: {
+        Troop troop{monkeys, ResidueArithmetic{divisors}};
+        return troop.playRounds(rounds, threadCount, skipCycles);
+    }
+    }
+
+    std::cerr << "invalid worry representation" << std::endl;
+    std::terminate();
+}
+
+std::vector<Value> firstPrimes(Value from, Size count)
+{
+    std::vector<Value> primes;
+
+    for (Value candidate = std::max(from, Value{2}); primes.size() < count; ++candidate) {
+        bool prime = true;
+
+        for (Value divisor = 2; divisor * divisor <= candidate; ++divisor) {
+            if (candidate % divisor == 0) {
+                prime = false;
+                break;
+            }
+        }
+
+        if (prime) {
+            primes.push_back(candidate);
+        }
+    }
+
+    return primes;
+}
+
+// Writes a random troop in the puzzle's input format.
+std::string generateTroop(const std::vector<Value> & divisors, std::mt19937 & rng)
+{
+    int monkeyCount = static_cast<int>(divisors.size());
+    std::uniform_int_distribution<int> itemDist{1, 99};
+    std::uniform_int_distribution<int> itemCountDist{1, 4};
+    std::uniform_int_distribution<int> operationDist{0, 5};
+    std::uniform_int_distribution<int> constantDist{1, 9};
+    std::uniform_int_distribution<int> targetDist{1, monkeyCount - 1};
+    std::ostringstream oss;
+
+    for (int monkey = 0; monkey < monkeyCount; ++monkey) {
+        if (monkey > 0) {
+            oss << "\n";
+        }
+
+        oss << "Monkey " << monkey << ":\n";
+        oss << "  Starting items: ";
+        int itemCount = itemCountDist(rng);
+        for (int i = 0; i < itemCount; ++i) {
+            oss << (i > 0 ? ", " : "") << itemDist(rng);
+        }
+        oss << "\n";
+
+        int operation = operationDist(rng);
+        if (operation == 0) {
+            oss << "  Operation: new = old * old\n";
+        }
+        else {
+            oss << "  Operation: new = old " << (operation % 2 ? '+' : '*') << " " << constantDist(rng) << "\n";
+        }
+
+        int trueTarget = (monkey + targetDist(rng)) % monkeyCount;
+        int falseTarget = trueTarget;
+        while ((falseTarget == trueTarget) && (monkeyCount > 2)) {
+            falseTarget = (monkey + targetDist(rng)) % monkeyCount;
+        }
+
+        oss << "  Test: divisible by " << divisors[monkey] << "\n";
+        oss << "    If true: throw to monkey " << trueTarget << "\n";
+        oss << "    If false: throw to monkey " << falseTarget << "\n";
+    }
+
+    return oss.str();
+}
+
+void benchmark(Rounds rounds)
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Scenario
+    {
+        std::string name;
+        Value firstDivisor;
+        Size monkeyCount;
+    };
+
+    const std::vector<Scenario> scenarios{
+        {"8 monkeys, divisors from 2", 2, 8},
+        {"6 monkeys, divisors from 1000", 1000, 6},
+        {"24 monkeys, divisors from 1000", 1000, 24},
+    };
+
+    std::mt19937 rng{11};
+
+    for (const auto & scenario : scenarios) {
+        std::istringstream iss{generateTroop(firstPrimes(scenario.firstDivisor, scenario.monkeyCount), rng)};
+        auto monkeys = parseMonkeys(iss);
+        auto selected = selectRepresentation(monkeys);
+
+        std::cout << scenario.name << " (selects " << representationToString(selected)
+                  << "), " << rounds << " rounds" << std::endl;
+
+        for (auto representation : {WorryRepresentation::Narrow,
+                                    WorryRepresentation::Wide,
+                                    WorryRepresentation::Residue}) {
+            // Skip representations that would overflow.
+            if (representation < selected) {
+                continue;
+            }
+
+            auto start{Clock::now()};
+            auto inspections{playTroop(monkeys, representation, rounds, 1, false)};
+            std::chrono::duration<double, std::milli> elapsed{Clock::now() - start};
+
+            std::cout << "  " << std::setw(10) << std::left << representationToString(representation)
+                      << std::setw(24) << scoreToString(scoreInspections(inspections))
+                      << std::fixed << std::setprecision(1) << elapsed.count() << " ms" << std::endl;
         }
     }
 }
 
-Value scoreGame(const MonkeyIndexMap & monkeys)
+Score scoreGame(const MonkeyIndexMap & monkeys)
 {
     std::vector<Value> scores;
 
@@ -314,21 +877,96 @@ Value scoreGame(const MonkeyIndexMap & monkeys)
                    [](const std::pair<int, Monkey> & monkeyPair) {
                        return monkeyPair.second.totalInspections();
                    });
-    std::sort(scores.begin(), scores.end());
 
-    return std::accumulate(
-        scores.rbegin(),
-        std::next(scores.rbegin(), 2),
-        Value{1},
-        std::multiplies<Value>());
+    return scoreInspections(scores);
 }
 
-int main()
+int main(int argc, char * argv[])
 {
+    Rounds rounds = numRounds;
+    unsigned threadCount = 1;
+    bool classic = false;
+    bool skipCycles = false;
+    bool runBenchmark = false;
+    std::optional<WorryRepresentation> forcedRepresentation;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+
+        if (arg == "--classic") {
+            classic = true;
+        }
+        else if (arg == "--skip") {
+            skipCycles = true;
+        }
+        else if ((arg == "--rounds") && (i + 1 < argc)) {
+            rounds = std::stoll(argv[++i]);
+        }
+        else if ((arg == "--threads") && (i + 1 < argc)) {
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if ((arg == "--worry") && (i + 1 < argc)) {
+            std::string name{argv[++i]};
+            forcedRepresentation.reset();
+
+            for (auto representation : {WorryRepresentation::Narrow,
+                                        WorryRepresentation::Wide,
+                                        WorryRepresentation::Residue}) {
+                if (name == representationToString(representation)) {
+                    forcedRepresentation = representation;
+                }
+            }
+
+            if (!forcedRepresentation) {
+                usage = true;
+            }
+        }
+        else if (arg == "--bench") {
+            runBenchmark = true;
+        }
+        else {
+            usage = true;
+        }
+
+        if (usage) {
+            std::cerr << "usage: " << argv[0]
+                      << " [--classic] [--skip] [--rounds N] [--threads N]"
+                      << " [--worry narrow|wide|residue] [--bench]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (runBenchmark) {
+        benchmark(rounds);
+        return 0;
+    }
+
     auto monkeys = parseMonkeys(std::cin);
-    playGame(monkeys);
 
-    std::cout << scoreGame(monkeys) << std::endl;
-        
+    // Original round-by-round simulation over the monkey map.
+    if (classic) {
+        playGame(monkeys, rounds);
+        std::cout << scoreToString(scoreGame(monkeys)) << std::endl;
+        return 0;
+    }
+
+    auto representation{forcedRepresentation.value_or(selectRepresentation(monkeys))};
+    auto inspections{playTroop(monkeys, representation, rounds, threadCount, skipCycles)};
+
+#ifdef DEBUG
+    std::cout << "worry representation: " << representationToString(representation) << std::endl;
+
+    if (skipCycles) {
+        auto checkRounds{std::min(rounds, numRounds)};
+        auto expected{playTroop(monkeys, representation, checkRounds, threadCount, false)};
+        auto skipped{playTroop(monkeys, representation, checkRounds, threadCount, true)};
+        std::cout << "cycle skipping " << (expected == skipped ? "matches" : "differs from")
+                  << " brute force over " << checkRounds << " rounds" << std::endl;
+    }
+#endif
+
+    std::cout << scoreToString(scoreInspections(inspections)) << std::endl;
+
     return 0;
 }
@@ -1,61 +1,71 @@
-#include <deque>
+#include <algorithm>
+#include <compare>
+#include <cstdint>
 #include <iostream>
 #include <numeric>
-#include <sstream>
-#include <variant>
+#include <span>
+#include <string>
 #include <vector>
 
 using PacketInteger = std::int32_t;
 
-class PacketArray;
+enum class TokenType : std::uint8_t { Open, Close, Integer };
 
-using PacketData = std::variant<PacketInteger, PacketArray>;
+struct PacketToken
+{
+    TokenType type;
+    PacketInteger value;
+
+    bool operator==(const PacketToken &) const = default;
+};
 
-class PacketArray
-    : public std::deque<PacketData>
+using PacketView = std::span<const PacketToken>;
+
+// Location of a packet's tokens within its arena.
+struct Packet
 {
-private: 
-    using std::deque<PacketData>::deque;
+    std::size_t offset;
+    std::size_t length;
+};
 
-    void parsePacketString(std::string packetString)
-    {
-        auto iter = std::next(packetString.begin());
-        parsePacketString(iter, packetString.end());
-    }
+// Stores every packet of a file as one flat token stream.
+class PacketArena
+{
+private:
+    std::vector<PacketToken> _tokens;
 
-    void parsePacketString(std::string::iterator & iter,
-                           const std::string::iterator & endIter)
+public:
+    Packet parse(const std::string & packetString)
     {
-        while (iter != endIter) {
+        Packet packet{_tokens.size(), 0};
+        auto iter = packetString.begin();
+
+        while (iter != packetString.end()) {
             // Check for digits.
             if ((*iter >= '0') && (*iter <= '9')) {
-                std::stringstream ss;
+                PacketInteger pi = 0;
 
-                while ((*iter >= '0') && (*iter <= '9')) {
-                    ss << *iter;
+                while ((iter != packetString.end()) && (*iter >= '0') && (*iter <= '9')) {
+                    pi = pi * 10 + (*iter - '0');
                     ++iter;
                 }
 
-                PacketInteger pi;
-                ss >> pi;
-
-                push_back(pi);
+                _tokens.push_back({TokenType::Integer, pi});
                 continue;
             }
 
             // Check for array opening.
             if (*iter == '[') {
+                _tokens.push_back({TokenType::Open, 0});
                 ++iter;
-                PacketArray pa;
-                pa.parsePacketString(iter, endIter);
-                push_back(pa);
                 continue;
             }
 
             // Check for array closing.
             if (*iter == ']') {
+                _tokens.push_back({TokenType::Close, 0});
                 ++iter;
-                break;
+                continue;
             }
 
             // Check for comma.
@@ -64,44 +74,106 @@ private:
                 continue;
             }
 
-            std::cerr << "parsing failure: " << std::string(iter, endIter) << std::endl;
+            std::cerr << "parsing failure: " << std::string(iter, packetString.end()) << std::endl;
             std::terminate();
         }
+
+        packet.length = _tokens.size() - packet.offset;
+        return packet;
+    }
+
+    PacketView view(const Packet & packet)
+        const
+    {
+        return PacketView(_tokens).subspan(packet.offset, packet.length);
     }
 
+    void reserve(std::size_t tokenCount) { _tokens.reserve(tokenCount); }
+};
+
+bool identical(const PacketView & a, const PacketView & b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+// Walks a token stream, synthesising the closing brackets of integers that
+// were promoted to single-element lists.
+class PacketCursor
+{
+private:
+    PacketView _tokens;
+    std::size_t _position;
+    std::size_t _promotions;
+    std::size_t _virtualCloses;
+
 public:
-    explicit PacketArray(const std::string & packetString)
+    explicit PacketCursor(const PacketView & tokens)
+        : _tokens(tokens)
+        , _position(0)
+        , _promotions(0)
+        , _virtualCloses(0)
+    {}
+
+    bool atEnd() const { return (_virtualCloses == 0) && (_position == _tokens.size()); }
+
+    PacketToken peek()
+        const
+    {
+        if (_virtualCloses > 0) {
+            return {TokenType::Close, 0};
+        }
+
+        return _tokens[_position];
+    }
+
+    // Treat the current integer as an opened list containing only itself.
+    void promote() { ++_promotions; }
+
+    void advance()
     {
-        parsePacketString(packetString);
+        if (_virtualCloses > 0) {
+            --_virtualCloses;
+            return;
+        }
+
+        if (_tokens[_position].type == TokenType::Integer) {
+            _virtualCloses = _promotions;
+            _promotions = 0;
+        }
+
+        ++_position;
     }
 };
 
 enum class TriBool { False, True, Indeterminate };
 
-TriBool isRightOrder(PacketArray left, PacketArray right)
+TriBool isRightOrder(const PacketView & left, const PacketView & right)
 {
-    while (true) {
-        if (left.empty() && !right.empty()) {
+    PacketCursor leftCursor{left};
+    PacketCursor rightCursor{right};
+
+    while (!leftCursor.atEnd() && !rightCursor.atEnd()) {
+        auto leftCurr{leftCursor.peek()};
+        auto rightCurr{rightCursor.peek()};
+
+        // Both lists end together.
+        if ((leftCurr.type == TokenType::Close) &&
+            (rightCurr.type == TokenType::Close)) {
+            leftCursor.advance();
+            rightCursor.advance();
+        }
+        // Left list ran out first.
+        else if (leftCurr.type == TokenType::Close) {
             return TriBool::True;
         }
-        else if (!left.empty() && right.empty()) {
+        // Right list ran out first.
+        else if (rightCurr.type == TokenType::Close) {
             return TriBool::False;
         }
-        else if (left.empty() && right.empty()) {
-            return TriBool::Indeterminate;
-        }
-
-        auto leftCurr{left.front()};
-        auto rightCurr{right.front()};
-        left.pop_front();
-        right.pop_front();
-
         // Both values are integers.
-        if ((std::holds_alternative<PacketInteger>(leftCurr)) &&
-            (std::holds_alternative<PacketInteger>(rightCurr))) {
-            const auto & leftInt = std::get<PacketInteger>(leftCurr);
-            const auto & rightInt = std::get<PacketInteger>(rightCurr);
-            auto ordering = leftInt <=> rightInt;
+        else if ((leftCurr.type == TokenType::Integer) &&
+                 (rightCurr.type == TokenType::Integer)) {
+            auto ordering = leftCurr.value <=> rightCurr.value;
 
             if (ordering < 0) {
                 return TriBool::True;
@@ -109,52 +181,35 @@ TriBool isRightOrder(PacketArray left, PacketArray right)
             else if (ordering > 0) {
                 return TriBool::False;
             }
+
+            leftCursor.advance();
+            rightCursor.advance();
         }
         // Both values are lists.
-        else if ((std::holds_alternative<PacketArray>(leftCurr)) &&
-                 (std::holds_alternative<PacketArray>(rightCurr))) {
-            const auto & leftArr = std::get<PacketArray>(leftCurr);
-            const auto & rightArr = std::get<PacketArray>(rightCurr);
-            auto result{isRightOrder(leftArr, rightArr)};
-
-            if (result != TriBool::Indeterminate) {
-                return result;
-            }
+        else if ((leftCurr.type == TokenType::Open) &&
+                 (rightCurr.type == TokenType::Open)) {
+            leftCursor.advance();
+            rightCursor.advance();
         }
         // Exactly one value is an integer (left integer).
-        else if ((std::holds_alternative<PacketInteger>(leftCurr)) &&
-                 (!std::holds_alternative<PacketInteger>(rightCurr))) {
-            PacketArray leftArr;
-            leftArr.push_back(std::get<PacketInteger>(leftCurr));
-            const auto & rightArr = std::get<PacketArray>(rightCurr);
-            auto result{isRightOrder(leftArr, rightArr)};
-
-            if (result != TriBool::Indeterminate) {
-                return result;
-            }
+        else if (leftCurr.type == TokenType::Integer) {
+            leftCursor.promote();
+            rightCursor.advance();
         }
         // Exactly one value is an integer (right integer).
-        else if ((!std::holds_alternative<PacketInteger>(leftCurr)) &&
-                  (std::holds_alternative<PacketInteger>(rightCurr))) {
-            const auto & leftArr = std::get<PacketArray>(leftCurr);
-            PacketArray rightArr;
-            rightArr.push_back(std::get<PacketInteger>(rightCurr));
-            auto result{isRightOrder(leftArr, rightArr)};
-
-            if (result != TriBool::Indeterminate) {
-                return result;
-            }
-        }
         else {
-            std::cerr << "unknown state while determining order" << std::endl;
-            std::terminate();
+            leftCursor.advance();
+            rightCursor.promote();
         }
     }
+
+    return TriBool::Indeterminate;
 }
 
 int processPackets(std::istream & is)
 {
     std::vector<int> rightOrderIndices;
+    PacketArena arena;
 
     int index = 1;
 
@@ -164,9 +219,9 @@ int processPackets(std::istream & is)
         std::getline(is, rightStr);
         std::getline(is, blank);
 
-        PacketArray left{leftStr};
-        PacketArray right{rightStr};
-        auto result{isRightOrder(left, right)};
+        auto left{arena.parse(leftStr)};
+        auto right{arena.parse(rightStr)};
+        auto result{isRightOrder(arena.view(left), arena.view(right))};
 
         if (result == TriBool::True) {
             rightOrderIndices.push_back(index);
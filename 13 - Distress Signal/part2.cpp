@@ -1,61 +1,76 @@
-#include <deque>
+#include <algorithm>
+#include <chrono>
+#include <compare>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <numeric>
-#include <sstream>
-#include <variant>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
 #include <vector>
 
 using PacketInteger = std::int32_t;
 
-class PacketArray;
+enum class TokenType : std::uint8_t { Open, Close, Integer };
 
-using PacketData = std::variant<PacketInteger, PacketArray>;
+struct PacketToken
+{
+    TokenType type;
+    PacketInteger value;
+
+    bool operator==(const PacketToken &) const = default;
+};
 
-class PacketArray
-    : public std::deque<PacketData>
+using PacketView = std::span<const PacketToken>;
+
+// Location of a packet's tokens within its arena.
+struct Packet
 {
-private: 
-    using std::deque<PacketData>::deque;
+    std::size_t offset;
+    std::size_t length;
+};
 
-    void parsePacketString(std::string packetString)
-    {
-        auto iter = std::next(packetString.begin());
-        parsePacketString(iter, packetString.end());
-    }
+// Stores every packet of a file as one flat token stream.
+class PacketArena
+{
+private:
+    std::vector<PacketToken> _tokens;
 
-    void parsePacketString(std::string::iterator & iter,
-                           const std::string::iterator & endIter)
+public:
+    Packet parse(const std::string & packetString)
     {
-        while (iter != endIter) {
+        Packet packet{_tokens.size(), 0};
+        auto iter = packetString.begin();
+
+        while (iter != packetString.end()) {
             // Check for digits.
             if ((*iter >= '0') && (*iter <= '9')) {
-                std::stringstream ss;
+                PacketInteger pi = 0;
 
-                while ((*iter >= '0') && (*iter <= '9')) {
-                    ss << *iter;
+                while ((iter != packetString.end()) && (*iter >= '0') && (*iter <= '9')) {
+                    pi = pi * 10 + (*iter - '0');
                     ++iter;
                 }
 
-                PacketInteger pi;
-                ss >> pi;
-
-                push_back(pi);
+                _tokens.push_back({TokenType::Integer, pi});
                 continue;
             }
 
             // Check for array opening.
             if (*iter == '[') {
+                _tokens.push_back({TokenType::Open, 0});
                 ++iter;
-                PacketArray pa;
-                pa.parsePacketString(iter, endIter);
-                push_back(pa);
                 continue;
             }
 
             // Check for array closing.
             if (*iter == ']') {
+                _tokens.push_back({TokenType::Close, 0});
                 ++iter;
-                break;
+                continue;
             }
 
             // Check for comma.
@@ -64,83 +79,106 @@ private:
                 continue;
             }
 
-            std::cerr << "parsing failure: " << std::string(iter, endIter) << std::endl;
+            std::cerr << "parsing failure: " << std::string(iter, packetString.end()) << std::endl;
             std::terminate();
         }
+
+        packet.length = _tokens.size() - packet.offset;
+        return packet;
     }
 
-public:
-    explicit PacketArray(const std::string & packetString)
+    PacketView view(const Packet & packet)
+        const
     {
-        parsePacketString(packetString);
+        return PacketView(_tokens).subspan(packet.offset, packet.length);
     }
+
+    void reserve(std::size_t tokenCount) { _tokens.reserve(tokenCount); }
 };
 
-bool identical(PacketArray a, PacketArray b)
+bool identical(const PacketView & a, const PacketView & b)
 {
-    while (true) {
-        if (a.empty() && b.empty()) {
-            return true;
-        }
-        else if (a.empty() || b.empty()) {
-            return false;
-        }
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
 
-        auto currA{a.front()};
-        auto currB{b.front()};
-        a.pop_front();
-        b.pop_front();
+// Walks a token stream, synthesising the closing brackets of integers that
+// were promoted to single-element lists.
+class PacketCursor
+{
+private:
+    PacketView _tokens;
+    std::size_t _position;
+    std::size_t _promotions;
+    std::size_t _virtualCloses;
 
-        // Both values are integers.
-        if ((std::holds_alternative<PacketInteger>(currA)) &&
-            (std::holds_alternative<PacketInteger>(currB))) {
-            const auto & intA = std::get<PacketInteger>(currA);
-            const auto & intB = std::get<PacketInteger>(currB);
-            if (intA != intB) {
-                return false;
-            }
+public:
+    explicit PacketCursor(const PacketView & tokens)
+        : _tokens(tokens)
+        , _position(0)
+        , _promotions(0)
+        , _virtualCloses(0)
+    {}
+
+    bool atEnd() const { return (_virtualCloses == 0) && (_position == _tokens.size()); }
+
+    PacketToken peek()
+        const
+    {
+        if (_virtualCloses > 0) {
+            return {TokenType::Close, 0};
         }
-        // Both values are lists.
-        else if ((std::holds_alternative<PacketArray>(currA)) &&
-                 (std::holds_alternative<PacketArray>(currB))) {
-            if (!identical(std::get<PacketArray>(currA),
-                           std::get<PacketArray>(currB))) {
-                return false;
-            }
+
+        return _tokens[_position];
+    }
+
+    // Treat the current integer as an opened list containing only itself.
+    void promote() { ++_promotions; }
+
+    void advance()
+    {
+        if (_virtualCloses > 0) {
+            --_virtualCloses;
+            return;
         }
-        // Mismatched types.
-        else {
-            return false;
+
+        if (_tokens[_position].type == TokenType::Integer) {
+            _virtualCloses = _promotions;
+            _promotions = 0;
         }
+
+        ++_position;
     }
-}
+};
 
 enum class TriBool { False, True, Indeterminate };
 
-TriBool isRightOrder(PacketArray left, PacketArray right)
+TriBool isRightOrder(const PacketView & left, const PacketView & right)
 {
-    while (true) {
-        if (left.empty() && !right.empty()) {
+    PacketCursor leftCursor{left};
+    PacketCursor rightCursor{right};
+
+    while (!leftCursor.atEnd() && !rightCursor.atEnd()) {
+        auto leftCurr{leftCursor.peek()};
+        auto rightCurr{rightCursor.peek()};
+
+        // Both lists end together.
+        if ((leftCurr.type == TokenType::Close) &&
+            (rightCurr.type == TokenType::Close)) {
+            leftCursor.advance();
+            rightCursor.advance();
+        }
+        // Left list ran out first.
+        else if (leftCurr.type == TokenType::Close) {
             return TriBool::True;
         }
-        else if (!left.empty() && right.empty()) {
+        // Right list ran out first.
+        else if (rightCurr.type == TokenType::Close) {
             return TriBool::False;
         }
-        else if (left.empty() && right.empty()) {
-            return TriBool::Indeterminate;
-        }
-
-        auto leftCurr{left.front()};
-        auto rightCurr{right.front()};
-        left.pop_front();
-        right.pop_front();
-
         // Both values are integers.
-        if ((std::holds_alternative<PacketInteger>(leftCurr)) &&
-            (std::holds_alternative<PacketInteger>(rightCurr))) {
-            const auto & leftInt = std::get<PacketInteger>(leftCurr);
-            const auto & rightInt = std::get<PacketInteger>(rightCurr);
-            auto ordering = leftInt <=> rightInt;
+        else if ((leftCurr.type == TokenType::Integer) &&
+                 (rightCurr.type == TokenType::Integer)) {
+            auto ordering = leftCurr.value <=> rightCurr.value;
 
             if (ordering < 0) {
                 return TriBool::True;
@@ -148,100 +186,275 @@ TriBool isRightOrder(PacketArray left, PacketArray right)
             else if (ordering > 0) {
                 return TriBool::False;
             }
+
+            leftCursor.advance();
+            rightCursor.advance();
         }
         // Both values are lists.
-        else if ((std::holds_alternative<PacketArray>(leftCurr)) &&
-                 (std::holds_alternative<PacketArray>(rightCurr))) {
-            const auto & leftArr = std::get<PacketArray>(leftCurr);
-            const auto & rightArr = std::get<PacketArray>(rightCurr);
-            auto result{isRightOrder(leftArr, rightArr)};
-
-            if (result != TriBool::Indeterminate) {
-                return result;
-            }
+        else if ((leftCurr.type == TokenType::Open) &&
+                 (rightCurr.type == TokenType::Open)) {
+            leftCursor.advance();
+            rightCursor.advance();
         }
         // Exactly one value is an integer (left integer).
-        else if ((std::holds_alternative<PacketInteger>(leftCurr)) &&
-                 (!std::holds_alternative<PacketInteger>(rightCurr))) {
-            PacketArray leftArr;
-            leftArr.push_back(std::get<PacketInteger>(leftCurr));
-            const auto & rightArr = std::get<PacketArray>(rightCurr);
-            auto result{isRightOrder(leftArr, rightArr)};
-
-            if (result != TriBool::Indeterminate) {
-                return result;
-            }
+        else if (leftCurr.type == TokenType::Integer) {
+            leftCursor.promote();
+            rightCursor.advance();
         }
         // Exactly one value is an integer (right integer).
-        else if ((!std::holds_alternative<PacketInteger>(leftCurr)) &&
-                  (std::holds_alternative<PacketInteger>(rightCurr))) {
-            const auto & leftArr = std::get<PacketArray>(leftCurr);
-            PacketArray rightArr;
-            rightArr.push_back(std::get<PacketInteger>(rightCurr));
-            auto result{isRightOrder(leftArr, rightArr)};
-
-            if (result != TriBool::Indeterminate) {
-                return result;
-            }
-        }
         else {
-            std::cerr << "unknown state while determining order" << std::endl;
-            std::terminate();
+            leftCursor.advance();
+            rightCursor.promote();
+        }
+    }
+
+    return TriBool::Indeterminate;
+}
+
+std::string packetToString(const PacketView & packet)
+{
+    std::string result;
+    bool needComma = false;
+
+    for (const auto & token : packet) {
+        if ((token.type != TokenType::Close) && needComma) {
+            result += ',';
+        }
+
+        switch (token.type) {
+        case TokenType::Open: {
+            result += '[';
+            needComma = false;
+            break;
+        }
+        case TokenType::Close: {
+            result += ']';
+            needComma = true;
+            break;
+        }
+        case TokenType::Integer: {
+            result += std::to_string(token.value);
+            needComma = true;
+            break;
+        }
+        }
+    }
+
+    return result;
+}
+
+// Packets of a file parsed into an arena, with the two divider packets kept
+// apart from the others.
+struct PacketList
+{
+    PacketArena arena;
+    std::vector<Packet> packets;
+    Packet dividerA;
+    Packet dividerB;
+
+    PacketList()
+        : dividerA(arena.parse("[[2]]"))
+        , dividerB(arena.parse("[[6]]"))
+    {}
+};
+
+PacketList parsePackets(std::istream & is)
+{
+    PacketList list;
+
+    for (std::string line; std::getline(is, line);) {
+        if (!line.empty()) {
+            list.packets.push_back(list.arena.parse(line));
         }
     }
+
+    return list;
 }
 
-int processPackets(std::istream & is)
+using DecoderKey = std::int64_t;
+
+// Every packet ordered before a divider shifts that divider's index by one,
+// so counting them once each gives both indices without sorting.
+DecoderKey decoderKeyByCounting(const PacketList & list, unsigned threadCount)
 {
-    std::vector<PacketArray> packetArrayVector;
-    PacketArray dividerA{"[[2]]"};
-    PacketArray dividerB{"[[6]]"};
-    packetArrayVector.push_back(dividerA);
-    packetArrayVector.push_back(dividerB);
-
-    do {
-        std::string leftStr, rightStr, blank;
-        std::getline(is, leftStr);
-        std::getline(is, rightStr);
-        std::getline(is, blank);
-
-        PacketArray left{leftStr};
-        PacketArray right{rightStr};
-        packetArrayVector.push_back(left);
-        packetArrayVector.push_back(right);
-    } while(!is.eof());
-
-    std::sort(
-        packetArrayVector.begin(),
-        packetArrayVector.end(),
-        [](auto left, auto right){
-            auto result = isRightOrder(left, right);
+    const auto & packets{list.packets};
+    threadCount = std::max(1u, std::min<unsigned>(threadCount, packets.size() / 1024 + 1));
+
+    std::vector<std::size_t> beforeA(threadCount, 0);
+    std::vector<std::size_t> beforeB(threadCount, 0);
+
+    auto countRange = [&](unsigned thread) {
+        auto viewA{list.arena.view(list.dividerA)};
+        auto viewB{list.arena.view(list.dividerB)};
+        std::size_t begin = packets.size() * thread / threadCount;
+        std::size_t end = packets.size() * (thread + 1) / threadCount;
+
+        // Count locally; the per-thread slots share cache lines.
+        std::size_t countA = 0;
+        std::size_t countB = 0;
+
+        for (std::size_t i = begin; i < end; ++i) {
+            auto view{list.arena.view(packets[i])};
+
+            // Anything before [[2]] is also before [[6]].
+            if (isRightOrder(view, viewA) == TriBool::True) {
+                ++countA;
+                ++countB;
+            }
+            else if (isRightOrder(view, viewB) == TriBool::True) {
+                ++countB;
+            }
+        }
+
+        beforeA[thread] = countA;
+        beforeB[thread] = countB;
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned thread = 1; thread < threadCount; ++thread) {
+        workers.emplace_back(countRange, thread);
+    }
+    countRange(0);
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    DecoderKey indexA = std::accumulate(beforeA.begin(), beforeA.end(), DecoderKey{1});
+    DecoderKey indexB = std::accumulate(beforeB.begin(), beforeB.end(), DecoderKey{2});
+
+    return indexA * indexB;
+}
+
+// Stable sorts the packets together with the dividers, for when the ordered
+// packets themselves are needed.
+std::vector<Packet> sortPackets(const PacketList & list)
+{
+    std::vector<Packet> packetVector{list.dividerA, list.dividerB};
+    packetVector.insert(packetVector.end(), list.packets.begin(), list.packets.end());
+
+    std::stable_sort(
+        packetVector.begin(),
+        packetVector.end(),
+        [&list](const auto & left, const auto & right){
+            auto result = isRightOrder(list.arena.view(left), list.arena.view(right));
             return result == TriBool::True;
         });
 
-    int indexA =
-        std::distance(packetArrayVector.begin(),
-                      std::find_if(packetArrayVector.begin(),
-                                   packetArrayVector.end(),
-                                   [&dividerA](const auto & packetArray) {
-                                       return identical(dividerA, packetArray);
-                                   }))
-        + 1;
-    int indexB =
-        std::distance(packetArrayVector.begin(),
-                      std::find_if(packetArrayVector.begin(),
-                                   packetArrayVector.end(),
-                                   [&dividerB](const auto & packetArray) {
-                                       return identical(dividerB, packetArray);
-                                   }))
-        + 1;
+    return packetVector;
+}
 
-    return indexA * indexB;
+DecoderKey decoderKeyBySorting(const PacketList & list, const std::vector<Packet> & sorted)
+{
+    auto findIndex = [&](const Packet & divider) {
+        auto iter{std::find_if(sorted.begin(),
+                               sorted.end(),
+                               [&](const auto & packet) {
+                                   return packet.offset == divider.offset;
+                               })};
+        return static_cast<DecoderKey>(std::distance(sorted.begin(), iter)) + 1;
+    };
+
+    return findIndex(list.dividerA) * findIndex(list.dividerB);
 }
 
-int main()
+std::string generatePacket(std::mt19937 & rng, int depth)
 {
-    std::cout << processPackets(std::cin) << std::endl;
+    std::uniform_int_distribution<int> valueDist{0, 10};
+    std::uniform_int_distribution<int> lengthDist{0, 4};
+    std::string result{"["};
+    int length = lengthDist(rng);
+
+    for (int i = 0; i < length; ++i) {
+        if (i > 0) {
+            result += ',';
+        }
+
+        if ((depth < 4) && (valueDist(rng) < 3)) {
+            result += generatePacket(rng, depth + 1);
+        }
+        else {
+            result += std::to_string(valueDist(rng));
+        }
+    }
+
+    return result + "]";
+}
+
+void benchmark(std::size_t packetCount, unsigned threadCount)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::mt19937 rng{13};
+    PacketList list;
+    list.arena.reserve(packetCount * 16);
+
+    for (std::size_t i = 0; i < packetCount; ++i) {
+        list.packets.push_back(list.arena.parse(generatePacket(rng, 1)));
+    }
+
+    auto report = [](const std::string & name, auto start, DecoderKey key) {
+        std::chrono::duration<double, std::milli> elapsed{Clock::now() - start};
+        std::cout << std::setw(24) << std::left << name
+                  << std::setw(16) << key
+                  << std::fixed << std::setprecision(1) << elapsed.count() << " ms" << std::endl;
+    };
+
+    std::cout << packetCount << " packets" << std::endl;
+
+    auto start{Clock::now()};
+    auto sorted{sortPackets(list)};
+    report("stable sort", start, decoderKeyBySorting(list, sorted));
+
+    for (unsigned threads = 1; threads <= threadCount; threads *= 2) {
+        start = Clock::now();
+        auto key{decoderKeyByCounting(list, threads)};
+        report("counting x" + std::to_string(threads), start, key);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    bool dumpSorted = false;
+    std::size_t benchmarkCount = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+
+        if (arg == "--sorted") {
+            dumpSorted = true;
+        }
+        else if ((arg == "--threads") && (i + 1 < argc)) {
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if ((arg == "--bench") && (i + 1 < argc)) {
+            benchmarkCount = std::stoull(argv[++i]);
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [--sorted] [--threads N] [--bench PACKETS]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (benchmarkCount > 0) {
+        benchmark(benchmarkCount, threadCount);
+        return 0;
+    }
+
+    auto list{parsePackets(std::cin)};
+
+    if (dumpSorted) {
+        auto sorted{sortPackets(list)};
+
+        for (const auto & packet : sorted) {
+            std::cout << packetToString(list.arena.view(packet)) << std::endl;
+        }
+
+        std::cout << decoderKeyBySorting(list, sorted) << std::endl;
+        return 0;
+    }
+
+    std::cout << decoderKeyByCounting(list, threadCount) << std::endl;
 
     return 0;
 }
@@ -1,10 +1,13 @@
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <regex>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 using Int = std::int64_t;
 using Size = std::size_t;
@@ -344,6 +347,11 @@ public:
     auto name() const { return _name; }
     auto leftName() const { return _leftName; }
     auto rightName() const { return _rightName; }
+    auto operation() const { return _operation; }
+    auto leftPtr() const { return _leftPtr; }
+    auto rightPtr() const { return _rightPtr; }
+    auto isRoot() const { return _isRoot; }
+    auto isHuman() const { return _isHuman; }
 
     void setLeftPtr(MonkeyPtr leftPtr) { _leftPtr = leftPtr; }
     void setRightPtr(MonkeyPtr rightPtr) { _rightPtr = rightPtr; }
@@ -363,6 +371,457 @@ public:
     }
 };
 
+// Evaluates root's two sides for arbitrary human values by recomputing only
+// the monkeys on the path from human to root. Every subtree hanging off that
+// path is constant and evaluated exactly once during construction. Probes
+// use checked arithmetic and report division by zero or overflow like
+// LinearSolver does.
+class IncrementalEvaluator
+{
+private:
+    struct PathStep
+    {
+        Operation operation;
+        EquationSide humanSide;
+        Int constant;
+        MonkeyPtr monkey;
+    };
+
+    // Steps ordered from human's parent up to (not including) root.
+    std::vector<PathStep> _path;
+    EquationSide _rootHumanSide;
+    Int _rootConstant;
+    String _failure;
+
+    std::optional<std::pair<Int, Int>> fail(const String & reason)
+    {
+        _failure = reason;
+        return std::nullopt;
+    }
+
+    static bool findHuman(const MonkeyPtr & monkey,
+                          std::vector<std::pair<MonkeyPtr, EquationSide>> & trail)
+    {
+        if (monkey->isHuman()) {
+            return true;
+        }
+
+        if (!monkey->operation().has_value()) {
+            return false;
+        }
+
+        trail.push_back({monkey, EquationSide::Left});
+        if (findHuman(monkey->leftPtr(), trail)) {
+            return true;
+        }
+
+        trail.back().second = EquationSide::Right;
+        if (findHuman(monkey->rightPtr(), trail)) {
+            return true;
+        }
+
+        trail.pop_back();
+        return false;
+    }
+
+    static Int constantValue(const MonkeyPtr & monkey)
+    {
+        OperationResult result{monkey->value()};
+
+        if (!std::holds_alternative<Int>(result)) {
+            std::cerr << "constant subtree depends on human: " << monkey->name() << std::endl;
+            std::terminate();
+        }
+
+        return std::get<Int>(result);
+    }
+
+    static MonkeyPtr otherSide(const MonkeyPtr & monkey, EquationSide humanSide)
+    {
+        return humanSide == EquationSide::Left ? monkey->rightPtr() : monkey->leftPtr();
+    }
+
+public:
+    IncrementalEvaluator(const MonkeyPtr & root)
+    {
+        std::vector<std::pair<MonkeyPtr, EquationSide>> trail;
+
+        if (!root->isRoot() || !findHuman(root, trail)) {
+            std::cerr << "unable to find path from root to human" << std::endl;
+            std::terminate();
+        }
+
+        _rootHumanSide = trail.front().second;
+        _rootConstant = constantValue(otherSide(root, _rootHumanSide));
+
+        // Cache the constant operand of every monkey on the path.
+        for (auto it = trail.rbegin(); it != std::prev(trail.rend()); ++it) {
+            const auto & [monkey, humanSide] = *it;
+            _path.push_back({*monkey->operation(),
+                             humanSide,
+                             constantValue(otherSide(monkey, humanSide)),
+                             monkey});
+        }
+    }
+
+    auto depth() const { return _path.size(); }
+
+    // Returns root's (left, right) values when human yells the given value,
+    // or an empty optional with the reason available from failure().
+    std::optional<std::pair<Int, Int>> rootSides(Int human)
+    {
+        Int value = human;
+
+        for (const auto & step : _path) {
+            auto left = step.humanSide == EquationSide::Left ? value : step.constant;
+            auto right = step.humanSide == EquationSide::Left ? step.constant : value;
+            bool overflow = false;
+
+            switch (step.operation) {
+            case Operation::Addition: {
+                overflow = __builtin_add_overflow(left, right, &value);
+                break;
+            }
+            case Operation::Subtraction: {
+                overflow = __builtin_sub_overflow(left, right, &value);
+                break;
+            }
+            case Operation::Multiplication: {
+                overflow = __builtin_mul_overflow(left, right, &value);
+                break;
+            }
+            case Operation::Division: {
+                if (right == 0) {
+                    return fail("division by zero at monkey " + step.monkey->name());
+                }
+
+                overflow = (left == std::numeric_limits<Int>::min()) && (right == -1);
+                if (!overflow) {
+                    value = left / right;
+                }
+                break;
+            }
+            }
+
+            if (overflow) {
+                return fail("overflow at monkey " + step.monkey->name());
+            }
+        }
+
+        if (_rootHumanSide == EquationSide::Left) {
+            return std::pair{value, _rootConstant};
+        }
+
+        return std::pair{_rootConstant, value};
+    }
+
+    auto failure() const { return _failure; }
+};
+
+__extension__ typedef __int128 Wide;
+__extension__ typedef unsigned __int128 UnsignedWide;
+
+// The one Wide value without a negation.
+constexpr Wide wideMin = static_cast<Wide>(UnsignedWide(1) << 127);
+
+// value must not be wideMin.
+Wide wideAbs(Wide value) { return value < 0 ? -value : value; }
+
+Wide wideGcd(Wide a, Wide b)
+{
+    a = wideAbs(a);
+    b = wideAbs(b);
+
+    while (b != 0) {
+        Wide t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+// Exact rational with 128-bit numerator and denominator. Every operation
+// reports overflow by returning an empty optional. Neither part is ever
+// wideMin, so both can always be negated.
+class Fraction
+{
+private:
+    Wide _num;
+    Wide _den;
+
+    Fraction(Wide num, Wide den)
+        : _num(num)
+        , _den(den)
+    {
+        if (_den < 0) {
+            _num = -_num;
+            _den = -_den;
+        }
+
+        Wide divisor{wideGcd(_num, _den)};
+        if (divisor > 1) {
+            _num /= divisor;
+            _den /= divisor;
+        }
+    }
+
+    // Rejects a zero denominator and parts equal to wideMin.
+    static std::optional<Fraction> make(Wide num, Wide den)
+    {
+        if ((den == 0) || (num == wideMin) || (den == wideMin)) {
+            return std::nullopt;
+        }
+
+        return Fraction(num, den);
+    }
+
+public:
+    Fraction(Int value = 0)
+        : Fraction(value, 1)
+    {}
+
+    auto num() const { return _num; }
+    auto den() const { return _den; }
+    bool isZero() const { return _num == 0; }
+    bool isInteger() const { return _den == 1; }
+
+    std::optional<Fraction> add(const Fraction & other)
+        const
+    {
+        Wide divisor{wideGcd(_den, other._den)};
+        Wide left, right, num, den;
+
+        if (__builtin_mul_overflow(_num, other._den / divisor, &left) ||
+            __builtin_mul_overflow(other._num, _den / divisor, &right) ||
+            __builtin_add_overflow(left, right, &num) ||
+            __builtin_mul_overflow(_den, other._den / divisor, &den)) {
+            return std::nullopt;
+        }
+
+        return make(num, den);
+    }
+
+    std::optional<Fraction> negate()
+        const
+    {
+        Wide num;
+
+        if (__builtin_sub_overflow(Wide(0), _num, &num)) {
+            return std::nullopt;
+        }
+
+        return make(num, _den);
+    }
+
+    std::optional<Fraction> subtract(const Fraction & other)
+        const
+    {
+        auto negated{other.negate()};
+
+        if (!negated) {
+            return std::nullopt;
+        }
+
+        return add(*negated);
+    }
+
+    std::optional<Fraction> multiply(const Fraction & other)
+        const
+    {
+        // Cross-reduce first to keep intermediates small.
+        Wide leftGcd{wideGcd(_num, other._den)};
+        Wide rightGcd{wideGcd(other._num, _den)};
+        leftGcd = leftGcd == 0 ? 1 : leftGcd;
+        rightGcd = rightGcd == 0 ? 1 : rightGcd;
+        Wide num, den;
+
+        if (__builtin_mul_overflow(_num / leftGcd, other._num / rightGcd, &num) ||
+            __builtin_mul_overflow(_den / rightGcd, other._den / leftGcd, &den)) {
+            return std::nullopt;
+        }
+
+        return make(num, den);
+    }
+
+    std::optional<Fraction> reciprocal()
+        const
+    {
+        if (isZero()) {
+            return std::nullopt;
+        }
+
+        return make(_den, _num);
+    }
+};
+
+// Value of a monkey as slope * human + intercept.
+struct LinearForm
+{
+    Fraction slope;
+    Fraction intercept;
+
+    bool isConstant() const { return slope.isZero(); }
+};
+
+// Solves root's equality exactly by propagating human as a linear form
+// through the monkey graph, instead of inverting operations with truncating
+// integer arithmetic.
+class LinearSolver
+{
+private:
+    std::unordered_map<const Monkey *, LinearForm> _forms;
+    String _failure;
+
+    std::optional<LinearForm> fail(const String & reason)
+    {
+        if (_failure.empty()) {
+            _failure = reason;
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<LinearForm> combine(const Monkey & monkey,
+                                      const LinearForm & left,
+                                      const LinearForm & right)
+    {
+        const String overflow{"overflow at monkey " + monkey.name()};
+
+        switch (*monkey.operation()) {
+        case Operation::Addition: {
+            auto slope{left.slope.add(right.slope)};
+            auto intercept{left.intercept.add(right.intercept)};
+            if (!slope || !intercept) {
+                return fail(overflow);
+            }
+            return LinearForm{*slope, *intercept};
+        }
+        case Operation::Subtraction: {
+            auto slope{left.slope.subtract(right.slope)};
+            auto intercept{left.intercept.subtract(right.intercept)};
+            if (!slope || !intercept) {
+                return fail(overflow);
+            }
+            return LinearForm{*slope, *intercept};
+        }
+        case Operation::Multiplication: {
+            if (!left.isConstant() && !right.isConstant()) {
+                return fail("human is multiplied by itself at monkey " + monkey.name());
+            }
+            const auto & factor{left.isConstant() ? left.intercept : right.intercept};
+            const auto & form{left.isConstant() ? right : left};
+            auto slope{form.slope.multiply(factor)};
+            auto intercept{form.intercept.multiply(factor)};
+            if (!slope || !intercept) {
+                return fail(overflow);
+            }
+            return LinearForm{*slope, *intercept};
+        }
+        case Operation::Division: {
+            if (!right.isConstant()) {
+                return fail("human appears in a divisor at monkey " + monkey.name());
+            }
+            auto factor{right.intercept.reciprocal()};
+            if (!factor) {
+                return fail("division by zero at monkey " + monkey.name());
+            }
+            auto slope{left.slope.multiply(*factor)};
+            auto intercept{left.intercept.multiply(*factor)};
+            if (!slope || !intercept) {
+                return fail(overflow);
+            }
+            return LinearForm{*slope, *intercept};
+        }
+        }
+
+        return fail("invalid operation at monkey " + monkey.name());
+    }
+
+    std::optional<LinearForm> form(const MonkeyPtr & monkey)
+    {
+        if (auto it = _forms.find(monkey.get()); it != _forms.end()) {
+            return it->second;
+        }
+
+        std::optional<LinearForm> result;
+
+        if (monkey->isHuman()) {
+            result = LinearForm{Fraction(1), Fraction(0)};
+        }
+        else if (!monkey->operation().has_value()) {
+            result = LinearForm{Fraction(0), Fraction(std::get<Int>(monkey->value()))};
+        }
+        else {
+            auto left{form(monkey->leftPtr())};
+            if (!left) {
+                return std::nullopt;
+            }
+            auto right{form(monkey->rightPtr())};
+            if (!right) {
+                return std::nullopt;
+            }
+            result = combine(*monkey, *left, *right);
+            if (!result) {
+                return std::nullopt;
+            }
+        }
+
+        _forms.insert({monkey.get(), *result});
+        return result;
+    }
+
+public:
+    // Returns the human value making root's sides equal, or an empty
+    // optional with the reason available from failure().
+    std::optional<Int> solve(const MonkeyPtr & root)
+    {
+        _forms.clear();
+        _failure.clear();
+
+        auto left{form(root->leftPtr())};
+        auto right{form(root->rightPtr())};
+        if (!left || !right) {
+            return std::nullopt;
+        }
+
+        // left.slope * x + left.intercept = right.slope * x + right.intercept
+        auto slope{right->slope.subtract(left->slope)};
+        auto intercept{left->intercept.subtract(right->intercept)};
+        if (!slope || !intercept) {
+            fail("overflow at monkey root");
+            return std::nullopt;
+        }
+
+        if (slope->isZero()) {
+            fail(intercept->isZero() ? "every human value satisfies root"
+                                     : "no human value satisfies root");
+            return std::nullopt;
+        }
+
+        auto solution{intercept->multiply(*slope->reciprocal())};
+        if (!solution) {
+            fail("overflow solving root");
+            return std::nullopt;
+        }
+
+        if (!solution->isInteger()) {
+            fail("root is only satisfied by a non-integer human value");
+            return std::nullopt;
+        }
+
+        if (solution->num() < std::numeric_limits<Int>::min() ||
+            solution->num() > std::numeric_limits<Int>::max()) {
+            fail("human value does not fit in 64 bits");
+            return std::nullopt;
+        }
+
+        return static_cast<Int>(solution->num());
+    }
+
+    auto failure() const { return _failure; }
+};
+
 MonkeyPtr parseMonkeys(std::istream & is)
 {
     std::unordered_map<String, MonkeyPtr> monkeyMap;
@@ -406,9 +865,57 @@ MonkeyPtr parseMonkeys(std::istream & is)
     return monkeyMap["root"];
 }
 
-int main()
+int main(int argc, char * argv[])
 {
     auto rootMonkey{parseMonkeys(std::cin)};
-    std::cout << std::get<Int>(rootMonkey->value()) << std::endl;
+
+    // Any arguments are human values to probe instead of solving.
+    if (argc > 1) {
+        IncrementalEvaluator evaluator{rootMonkey};
+        std::vector<Int> humans;
+
+        for (int i = 1; i < argc; ++i) {
+            humans.push_back(std::stoll(argv[i]));
+        }
+
+        int status = 0;
+
+        for (const auto & human : humans) {
+            auto sides{evaluator.rootSides(human)};
+
+            if (!sides.has_value()) {
+                std::cerr << "unable to evaluate human " << human << ": " << evaluator.failure() << std::endl;
+                status = 1;
+                continue;
+            }
+
+            std::cout << human << ": " << sides->first << " " << sides->second << std::endl;
+        }
+
+        return status;
+    }
+
+    LinearSolver solver;
+    auto solution{solver.solve(rootMonkey)};
+
+    if (!solution.has_value()) {
+        std::cerr << "unable to solve root: " << solver.failure() << std::endl;
+        return 1;
+    }
+
+#ifdef DEBUG
+    IncrementalEvaluator evaluator{rootMonkey};
+    if (auto sides{evaluator.rootSides(*solution)}) {
+        std::cout << "depth = " << evaluator.depth()
+                  << ", left = " << sides->first
+                  << ", right = " << sides->second
+                  << ", inverted = " << std::get<Int>(rootMonkey->value()) << std::endl;
+    }
+    else {
+        std::cout << "unable to evaluate solution: " << evaluator.failure() << std::endl;
+    }
+#endif
+
+    std::cout << *solution << std::endl;
     return 0;
 }